@@ -64,6 +64,9 @@
 #include <fstream>
 #include <unordered_map>
 #include <unordered_set>
+#include <thread>
+#include <utility>
+#include <memory>
 
 // STL extensions
 #ifdef _MSC_VER
@@ -74,6 +77,8 @@
 
 // CLib
 #include <memory.h>
+#include <ctype.h>
+#include <stdlib.h>
 
 // Boost
 #include <boost/bimap.hpp>
@@ -81,8 +86,20 @@
 // QParser
 #include "token.h"
 #include "tokenregistry.h"
+#include "terminalset.h"
+#include "symboltable.h"
+#include "numericliteral.h"
 #include "parseresult.h"
+#include "matchbuffer.h"
+#include "charscan.h"
+#include "regex.h"
+#include "lineindex.h"
+#include "lexerdfa.h"
+#include "keywordhash.h"
+#include "frozentokenregistry.h"
 #include "lexer.h"
+#include "lexerstream.h"
+#include "staticlexer.h"
 #include "grammar.h"
 #include "grammarlr.h"
 #include "grammarld.h"
@@ -34,6 +34,11 @@ void OSI_API_CALL OSIX::Parser::endGrammar()
   
   if(_this.grammar->CheckForwardDeclarations())
     _this->ConstructParser(_this.grammar);
+
+  // Let the lexer discard the silent terminals that the grammar does not use
+  QParser::TerminalSet nilTerminals, maskedTerminals;
+  _this.grammar->ClassifySilentTerminals(nilTerminals, maskedTerminals);
+  _this.lexer->SetSilentTerminals(nilTerminals, maskedTerminals);
 }
 
 void OSI_API_CALL OSIX::Parser::beginRaw()
@@ -107,7 +112,7 @@ void OSI_API_CALL OSIX::Parser::endLanguage()
 
 OSid OSI_API_CALL OSIX::Parser::beginProduction(const OSchar* productionName)
 {
-  return _this.grammar->BeginProduction(productionName);
+  return _this.grammar->BeginProduction(productionName, (uint)strlen(productionName));
 }
 
 void OSI_API_CALL OSIX::Parser::endProduction()
@@ -122,7 +127,7 @@ void OSI_API_CALL OSIX::Parser::productionToken(OSid token)
 
 OSid OSI_API_CALL OSIX::Parser::productionToken(const OSchar* tokenName)
 {
-  return _this.grammar->ProductionToken(tokenName);
+  return _this.grammar->ProductionToken(tokenName, (uint)strlen(tokenName));
 }
 
 OSid OSI_API_CALL OSIX::Parser::productionIdentifierDecl(const OSchar* typeName)
@@ -153,7 +158,7 @@ void OSI_API_CALL OSIX::Parser::productionLiteralToken(PARSER_LITERAL_TOKEN lite
 
 OSid OSI_API_CALL OSIX::Parser::declareProduction(const OSchar* productionName)
 {
-  return _this.grammar->DeclareProduction(productionName);
+  return _this.grammar->DeclareProduction(productionName, (uint)strlen(productionName));
 }
 
 void OSI_API_CALL OSIX::Parser::startProduction(OSid production)
@@ -199,7 +204,7 @@ OSobject OSI_API_CALL OSIX::Parser::getParseStream(OSobject parseResult)
 
 void OSI_API_CALL OSIX::Parser::precedence(const OSchar* token1Name, const OSchar* token2Name)
 {
-  _this.grammar->Precedence(token1Name, token2Name);
+  _this.grammar->Precedence(token1Name, (uint)strlen(token1Name), token2Name, (uint)strlen(token2Name));
 }
 
 void OSI_API_CALL OSIX::Parser::precedence(OSid token1, OSid token2)
@@ -209,7 +214,8 @@ void OSI_API_CALL OSIX::Parser::precedence(OSid token1, OSid token2)
 
 const OSchar* OSI_API_CALL OSIX::Parser::getTokenName(OSid token)
 {
-  return _this->GetTokenRegistry().GetTokenName(token).c_str();
+  // (The name remains valid for as long as the parser exists: the arena of the token registry never moves its names)
+  return _this->GetTokenName(token);
 }
 
 OSbool OSI_API_CALL OSIX::Parser::isIdentifier(OSid token)
@@ -0,0 +1,167 @@
+#ifndef __QPARSER_CHARSCAN_H__
+#define __QPARSER_CHARSCAN_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    CHARSCAN.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      Fast character scanning routines used by the lexer to skip over long
+      runs of input (such as the contents of comments and strings, words
+      and whitespace).
+
+    IMPLEMENTATION:
+      + Each routine has a scalar, an SSE2 (16 bytes at a time) and an AVX2
+        (32 bytes at a time) implementation. The best implementation
+        supported by the processor is selected at runtime the first time the
+        routine is used.
+      + Character classes are 256-bit sets of bytes. The AVX2 implementation
+        tests 32 bytes at a time for membership by looking up the low nibble
+        of every byte in a 16-entry table of bit rows (one bit per high
+        nibble). SSE2 has no byte shuffle, so its class scan is scalar.
+      + UTF-8 validation follows the lookup algorithm of Keiser and Lemire
+        in the AVX2 implementation: The high and low nibbles of each byte
+        and the high nibble of the byte that follows it index three tables
+        of error flags, which are combined with a test for the third and
+        fourth bytes of a sequence. An invalid chunk is searched again by
+        the scalar implementation to locate the error. The SSE2
+        implementation skips ASCII 16 bytes at a time and validates the
+        other sequences one at a time.
+      + Define QPARSER_CHARSCAN_SCALAR to disable the vectorized
+        implementations.
+*/
+
+/*                              COMPILER MACROS                             */
+#if !defined(QPARSER_CHARSCAN_SCALAR)
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define QPARSER_CHARSCAN_SSE2
+# endif
+# if defined(QPARSER_CHARSCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define QPARSER_CHARSCAN_AVX2
+# endif
+#endif
+
+/*                                 INCLUDES                                 */
+#ifdef QPARSER_CHARSCAN_SSE2
+# include <emmintrin.h>
+#endif
+#ifdef QPARSER_CHARSCAN_AVX2
+# include <immintrin.h>
+#endif
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  // A set of input characters
+  class CharClass
+  {
+  public:
+    // Construction (the class starts out empty)
+    INLINE CharClass() { Clear(); }
+
+    // Remove all characters from the class
+    INLINE void Clear();
+
+    // Add a character to the class
+    INLINE void Add(uint8 character);
+
+    // Remove a character from the class
+    INLINE void Remove(uint8 character);
+
+    // Replace the class by its complement
+    INLINE void Invert();
+
+    // Test whether the class contains a character
+    FORCE_INLINE bool Contains(uint8 character) const { return members[character] != 0; }
+
+  protected:
+    friend class CharScan;
+
+    uint8 members[256];           // Non-zero for every character in the class
+    uint8 nibbleRows[2][16];      // Bit (high nibble & 7) of nibbleRows[high nibble >> 3][low nibble] is set for every character in the class
+  };
+
+  class CharScan
+  {
+  public:
+    // Implementations of the scanning routines
+    enum Implementation
+    {
+      IMPLEMENTATION_SCALAR = 0,
+      IMPLEMENTATION_SSE2   = 1,
+      IMPLEMENTATION_AVX2   = 2
+    };
+
+    // Find the first character in [begin, end) that is equal to either of the given characters (returns end if there is none)
+    static FORCE_INLINE const_cstring FindEither(const_cstring begin, const_cstring end, char a, char b) { return GetFunctions().findEither(begin, end, a, b); }
+
+    // Find the first character in [begin, end) that is a member of the character class (returns end if there is none)
+    static FORCE_INLINE const_cstring FindInClass(const_cstring begin, const_cstring end, const CharClass& charClass);
+
+    // Find the first byte in [begin, end) that does not start a valid UTF-8 sequence (returns end if the input is valid UTF-8)
+    // (Overlong encodings, surrogates, code points beyond U+10FFFF and sequences truncated by the end are invalid)
+    static FORCE_INLINE const_cstring FindInvalidUtf8(const_cstring begin, const_cstring end) { return GetFunctions().findInvalidUtf8(begin, end); }
+
+    // Find the start of the UTF-8 sequence at position: the last byte in [max(begin, position - 3), position] that is not a
+    // continuation byte (returns position if there is none)
+    static INLINE const_cstring FindUtf8SequenceStart(const_cstring begin, const_cstring position);
+
+    // Get the implementation selected for this processor
+    static INLINE Implementation GetImplementation() { return GetFunctions().implementation; }
+
+    // Select the implementation to use (for testing and benchmarking; returns false if the processor does not support it)
+    static INLINE bool SetImplementation(Implementation implementation);
+
+  protected:
+    typedef const_cstring (*FindEitherFunction)(const_cstring begin, const_cstring end, char a, char b);
+    typedef const_cstring (*FindInClassFunction)(const_cstring begin, const_cstring end, const CharClass& charClass);
+    typedef const_cstring (*FindInvalidUtf8Function)(const_cstring begin, const_cstring end);
+
+    // The routines of the selected implementation
+    struct Functions
+    {
+      Implementation implementation;
+      FindEitherFunction findEither;
+      FindInClassFunction findInClass;
+      FindInvalidUtf8Function findInvalidUtf8;
+    };
+
+    // Number of characters tested directly before dispatching to the selected implementation (most words and runs of whitespace are short)
+    static const uint SHORT_RUN_LENGTH = 8;
+
+    static INLINE Functions& GetFunctions();
+    static INLINE Functions GetImplementationFunctions(Implementation implementation);
+    static INLINE bool IsSupported(Implementation implementation);
+    static INLINE Implementation SelectImplementation();
+
+    // Scalar implementation
+    static INLINE const_cstring FindEitherScalar(const_cstring begin, const_cstring end, char a, char b);
+    static INLINE const_cstring FindInClassScalar(const_cstring begin, const_cstring end, const CharClass& charClass);
+    static INLINE const_cstring FindInvalidUtf8Scalar(const_cstring begin, const_cstring end);
+
+    // Get the length of the valid UTF-8 sequence that starts with a non-ASCII byte at position (0 if the sequence is invalid)
+    static FORCE_INLINE uint MatchUtf8Sequence(const_cstring position, const_cstring end);
+
+#ifdef QPARSER_CHARSCAN_SSE2
+    // SSE2 implementation
+    static INLINE const_cstring FindEitherSSE2(const_cstring begin, const_cstring end, char a, char b);
+    static INLINE const_cstring FindInvalidUtf8SSE2(const_cstring begin, const_cstring end);
+#endif
+
+#ifdef QPARSER_CHARSCAN_AVX2
+    // AVX2 implementation
+    static const_cstring FindEitherAVX2(const_cstring begin, const_cstring end, char a, char b);
+    static const_cstring FindInClassAVX2(const_cstring begin, const_cstring end, const CharClass& charClass);
+    static const_cstring FindInvalidUtf8AVX2(const_cstring begin, const_cstring end);
+#endif
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "charscan.inl"
+
+#endif
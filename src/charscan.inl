@@ -0,0 +1,410 @@
+#ifdef  __QPARSER_CHARSCAN_H__
+#ifndef __QPARSER_CHARSCAN_INL__
+#define __QPARSER_CHARSCAN_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    CHARSCAN.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#endif
+
+namespace QParser
+{
+  // Get the index of the lowest set bit in a (non-zero) mask
+  FORCE_INLINE uint CharScanFirstBit(uint32 mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (uint)index;
+#else
+    return (uint)__builtin_ctz(mask);
+#endif
+  }
+
+  INLINE void CharClass::Clear()
+  {
+    memset(members, 0, sizeof(members));
+    memset(nibbleRows, 0, sizeof(nibbleRows));
+  }
+
+  INLINE void CharClass::Add(uint8 character)
+  {
+    members[character] = 1;
+    nibbleRows[character >> 7][character & 0x0f] |= uint8(1 << ((character >> 4) & 7));
+  }
+
+  INLINE void CharClass::Remove(uint8 character)
+  {
+    members[character] = 0;
+    nibbleRows[character >> 7][character & 0x0f] &= uint8(~(1 << ((character >> 4) & 7)));
+  }
+
+  INLINE void CharClass::Invert()
+  {
+    for(uint c = 0; c < 256; ++c)
+      members[c] = !members[c];
+    for(uint row = 0; row < 2; ++row)
+      for(uint c = 0; c < 16; ++c)
+        nibbleRows[row][c] = uint8(~nibbleRows[row][c]);
+  }
+
+  const uint CharScan::SHORT_RUN_LENGTH;
+
+  FORCE_INLINE const_cstring CharScan::FindInClass(const_cstring begin, const_cstring end, const CharClass& charClass)
+  {
+    const_cstring const shortEnd = (end - begin > ptrdiff_t(SHORT_RUN_LENGTH))? begin + SHORT_RUN_LENGTH : end;
+    for(; begin < shortEnd; ++begin)
+      if(charClass.Contains(uint8(*begin)))
+        return begin;
+    return (begin == end)? end : GetFunctions().findInClass(begin, end, charClass);
+  }
+
+  INLINE const_cstring CharScan::FindUtf8SequenceStart(const_cstring begin, const_cstring position)
+  {
+    const_cstring const limit = (position - begin > 3)? position - 3 : begin;
+    const_cstring start = position;
+    while((uint8(*start) & 0xc0) == 0x80)
+    {
+      if(start == limit)
+        return position;
+      --start;
+    }
+    return start;
+  }
+
+  INLINE bool CharScan::SetImplementation(Implementation implementation)
+  {
+    if(!IsSupported(implementation))
+      return false;
+
+    GetFunctions() = GetImplementationFunctions(implementation);
+    return true;
+  }
+
+  INLINE CharScan::Functions& CharScan::GetFunctions()
+  {
+    // (The implementation is selected once, the first time any routine is used)
+    static Functions functions = GetImplementationFunctions(SelectImplementation());
+    return functions;
+  }
+
+  INLINE CharScan::Functions CharScan::GetImplementationFunctions(Implementation implementation)
+  {
+    Functions functions;
+    functions.implementation = implementation;
+    switch(implementation)
+    {
+#ifdef QPARSER_CHARSCAN_AVX2
+    case IMPLEMENTATION_AVX2:
+      functions.findEither = &FindEitherAVX2;
+      functions.findInClass = &FindInClassAVX2;
+      functions.findInvalidUtf8 = &FindInvalidUtf8AVX2;
+      break;
+#endif
+#ifdef QPARSER_CHARSCAN_SSE2
+    case IMPLEMENTATION_SSE2:
+      functions.findEither = &FindEitherSSE2;
+      functions.findInClass = &FindInClassScalar; // (SSE2 has no byte shuffle to look up the class with)
+      functions.findInvalidUtf8 = &FindInvalidUtf8SSE2;
+      break;
+#endif
+    default:
+      functions.implementation = IMPLEMENTATION_SCALAR;
+      functions.findEither = &FindEitherScalar;
+      functions.findInClass = &FindInClassScalar;
+      functions.findInvalidUtf8 = &FindInvalidUtf8Scalar;
+      break;
+    }
+    return functions;
+  }
+
+  INLINE bool CharScan::IsSupported(Implementation implementation)
+  {
+    switch(implementation)
+    {
+    case IMPLEMENTATION_SCALAR: return true;
+#ifdef QPARSER_CHARSCAN_SSE2
+    case IMPLEMENTATION_SSE2:   return true; // (guaranteed by the compiler settings)
+#endif
+#ifdef QPARSER_CHARSCAN_AVX2
+    case IMPLEMENTATION_AVX2:   return __builtin_cpu_supports("avx2") != 0;
+#endif
+    default:                    return false;
+    }
+  }
+
+  INLINE CharScan::Implementation CharScan::SelectImplementation()
+  {
+    if(IsSupported(IMPLEMENTATION_AVX2))
+      return IMPLEMENTATION_AVX2;
+    if(IsSupported(IMPLEMENTATION_SSE2))
+      return IMPLEMENTATION_SSE2;
+    return IMPLEMENTATION_SCALAR;
+  }
+
+  INLINE const_cstring CharScan::FindEitherScalar(const_cstring begin, const_cstring end, char a, char b)
+  {
+    for(; begin < end; ++begin)
+      if(*begin == a || *begin == b)
+        return begin;
+    return end;
+  }
+
+  INLINE const_cstring CharScan::FindInClassScalar(const_cstring begin, const_cstring end, const CharClass& charClass)
+  {
+    for(; begin < end; ++begin)
+      if(charClass.Contains(uint8(*begin)))
+        return begin;
+    return end;
+  }
+
+  FORCE_INLINE uint CharScan::MatchUtf8Sequence(const_cstring position, const_cstring end)
+  {
+    // Determine the length of the sequence from its lead byte and the range of its second byte
+    // (The range of the second byte excludes overlong encodings, surrogates and code points beyond U+10FFFF)
+    const uint8 lead = uint8(*position);
+    uint length;
+    uint8 low = 0x80, high = 0xbf;
+    if(lead < 0xc2)
+      return 0;
+    else if(lead < 0xe0)
+      length = 2;
+    else if(lead < 0xf0)
+    {
+      length = 3;
+      if(lead == 0xe0) low = 0xa0;
+      if(lead == 0xed) high = 0x9f;
+    }
+    else if(lead < 0xf5)
+    {
+      length = 4;
+      if(lead == 0xf0) low = 0x90;
+      if(lead == 0xf4) high = 0x8f;
+    }
+    else
+      return 0;
+
+    if(end - position < ptrdiff_t(length) || uint8(position[1]) < low || uint8(position[1]) > high)
+      return 0;
+    for(uint c = 2; c < length; ++c)
+      if((uint8(position[c]) & 0xc0) != 0x80)
+        return 0;
+    return length;
+  }
+
+  INLINE const_cstring CharScan::FindInvalidUtf8Scalar(const_cstring begin, const_cstring end)
+  {
+    while(begin < end)
+    {
+      if(uint8(*begin) < 0x80)
+      {
+        ++begin;
+        continue;
+      }
+
+      const uint length = MatchUtf8Sequence(begin, end);
+      if(length == 0)
+        return begin;
+      begin += length;
+    }
+    return end;
+  }
+
+#ifdef QPARSER_CHARSCAN_SSE2
+  INLINE const_cstring CharScan::FindInvalidUtf8SSE2(const_cstring begin, const_cstring end)
+  {
+    // Skip ASCII 16 characters at a time and validate the other sequences one at a time
+    while(end - begin >= 16)
+    {
+      const uint32 mask = (uint32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)begin));
+      if(mask == 0)
+      {
+        begin += 16;
+        continue;
+      }
+
+      for(begin += CharScanFirstBit(mask); begin < end && uint8(*begin) >= 0x80;)
+      {
+        const uint length = MatchUtf8Sequence(begin, end);
+        if(length == 0)
+          return begin;
+        begin += length;
+      }
+    }
+
+    // Validate the remaining characters
+    return FindInvalidUtf8Scalar(begin, end);
+  }
+
+  INLINE const_cstring CharScan::FindEitherSSE2(const_cstring begin, const_cstring end, char a, char b)
+  {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+
+    // Compare 16 characters at a time (unaligned loads never read past the end of the input)
+    for(; end - begin >= 16; begin += 16)
+    {
+      const __m128i chunk = _mm_loadu_si128((const __m128i*)begin);
+      const uint32 mask = (uint32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)));
+      if(mask != 0)
+        return begin + CharScanFirstBit(mask);
+    }
+
+    // Scan the remaining characters
+    return FindEitherScalar(begin, end, a, b);
+  }
+#endif
+
+#ifdef QPARSER_CHARSCAN_AVX2
+  __attribute__((target("avx2"))) inline const_cstring CharScan::FindEitherAVX2(const_cstring begin, const_cstring end, char a, char b)
+  {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+
+    // Compare 32 characters at a time (unaligned loads never read past the end of the input)
+    for(; end - begin >= 32; begin += 32)
+    {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+      const uint32 mask = (uint32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb)));
+      if(mask != 0)
+        return begin + CharScanFirstBit(mask);
+    }
+
+    // Scan the remaining characters
+    return FindEitherSSE2(begin, end, a, b);
+  }
+
+  __attribute__((target("avx2"))) inline const_cstring CharScan::FindInClassAVX2(const_cstring begin, const_cstring end, const CharClass& charClass)
+  {
+    // (Each 128-bit lane shuffles its own copy of the tables)
+    const __m256i rowsLow  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)charClass.nibbleRows[0]));
+    const __m256i rowsHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)charClass.nibbleRows[1]));
+    const __m256i rowBits  = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                                              1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i eight      = _mm256_set1_epi8(8);
+
+    // Test 32 characters at a time (unaligned loads never read past the end of the input)
+    for(; end - begin >= 32; begin += 32)
+    {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+      const __m256i lowNibbles  = _mm256_and_si256(chunk, nibbleMask);
+      const __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibbleMask);
+
+      // Select the row for the low nibble and the bit for the high nibble
+      const __m256i rows = _mm256_blendv_epi8(_mm256_shuffle_epi8(rowsHigh, lowNibbles), _mm256_shuffle_epi8(rowsLow, lowNibbles), _mm256_cmpgt_epi8(eight, highNibbles));
+      const __m256i bits = _mm256_shuffle_epi8(rowBits, highNibbles);
+
+      const uint32 mask = (uint32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(rows, bits), bits));
+      if(mask != 0)
+        return begin + CharScanFirstBit(mask);
+    }
+
+    // Scan the remaining characters
+    return FindInClassScalar(begin, end, charClass);
+  }
+
+  __attribute__((target("avx2"))) inline const_cstring CharScan::FindInvalidUtf8AVX2(const_cstring begin, const_cstring end)
+  {
+    // Error flags of pairs of bytes (a flag is an error if it is set for the high and low nibbles of the first byte and the high nibble of the second)
+    const char TOO_SHORT = 1 << 0;      // 11______ 0_______ or 11______ 11______
+    const char TOO_LONG = 1 << 1;       // 0_______ 10______
+    const char OVERLONG_3 = 1 << 2;     // 11100000 100_____
+    const char TOO_LARGE = 1 << 3;      // 11110100 1001____, 11110100 101_____ or 11110101 and beyond
+    const char SURROGATE = 1 << 4;      // 11101101 101_____
+    const char OVERLONG_2 = 1 << 5;     // 1100000_ 10______
+    const char TOO_LARGE_1000 = 1 << 6; // 11110101 and beyond followed by 1000____
+    const char OVERLONG_4 = 1 << 6;     // 11110000 1000____
+    const char TWO_CONTS = char(1 << 7);// 10______ 10______ (unless the second byte is the third or fourth byte of a sequence)
+    const char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+    const __m256i byte1High = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+      TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+      TOO_SHORT | OVERLONG_2,
+      TOO_SHORT,
+      TOO_SHORT | OVERLONG_3 | SURROGATE,
+      TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4));
+    const __m256i byte1Low = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+      CARRY | OVERLONG_2,
+      CARRY,
+      CARRY,
+      CARRY | TOO_LARGE,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+      CARRY | TOO_LARGE | TOO_LARGE_1000,
+      CARRY | TOO_LARGE | TOO_LARGE_1000));
+    const __m256i byte2High = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+      TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+      TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT));
+
+    // (A chunk ends in an incomplete sequence if one of its last three bytes starts a sequence that is longer than the rest of the chunk)
+    const __m256i incompleteLimits = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                                      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, char(0xf0 - 1), char(0xe0 - 1), char(0xc0 - 1));
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i thirdByteLimit = _mm256_set1_epi8(char(0xe0 - 0x80));
+    const __m256i fourthByteLimit = _mm256_set1_epi8(char(0xf0 - 0x80));
+    const __m256i highBit = _mm256_set1_epi8(char(0x80));
+
+    const_cstring const validBegin = begin;
+    __m256i previousChunk = _mm256_setzero_si256();
+    __m256i previousIncomplete = _mm256_setzero_si256();
+
+    // Validate 32 characters at a time (unaligned loads never read past the end of the input)
+    for(; end - begin >= 32; begin += 32)
+    {
+      const __m256i chunk = _mm256_loadu_si256((const __m256i*)begin);
+      __m256i error;
+      if(_mm256_movemask_epi8(chunk) == 0)
+        error = previousIncomplete; // (an ASCII chunk is only invalid if the previous chunk ended in an incomplete sequence)
+      else
+      {
+        // Shift the previous 1, 2 and 3 bytes into each byte of the chunk
+        const __m256i previousLanes = _mm256_permute2x128_si256(previousChunk, chunk, 0x21);
+        const __m256i previous1 = _mm256_alignr_epi8(chunk, previousLanes, 15);
+        const __m256i previous2 = _mm256_alignr_epi8(chunk, previousLanes, 14);
+        const __m256i previous3 = _mm256_alignr_epi8(chunk, previousLanes, 13);
+
+        // Look up the error flags of every pair of bytes
+        const __m256i flags = _mm256_and_si256(_mm256_and_si256(
+            _mm256_shuffle_epi8(byte1High, _mm256_and_si256(_mm256_srli_epi16(previous1, 4), nibbleMask)),
+            _mm256_shuffle_epi8(byte1Low, _mm256_and_si256(previous1, nibbleMask))),
+            _mm256_shuffle_epi8(byte2High, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibbleMask)));
+
+        // The third and fourth bytes of a sequence must be continuation bytes (which is the only case in which TWO_CONTS is not an error)
+        const __m256i mustContinue = _mm256_and_si256(_mm256_or_si256(_mm256_subs_epu8(previous2, thirdByteLimit), _mm256_subs_epu8(previous3, fourthByteLimit)), highBit);
+        error = _mm256_or_si256(_mm256_xor_si256(mustContinue, flags), previousIncomplete);
+        previousIncomplete = _mm256_subs_epu8(chunk, incompleteLimits);
+      }
+
+      if(!_mm256_testz_si256(error, error))
+        break; // (locate the error below)
+      previousChunk = chunk;
+    }
+
+    // Validate the remaining characters (or locate the error) from the start of the sequence that contains the last validated character
+    return FindInvalidUtf8Scalar((begin > validBegin)? FindUtf8SequenceStart(validBegin, begin - 1) : begin, end);
+  }
+#endif
+}
+
+#endif
+#endif
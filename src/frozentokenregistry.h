@@ -0,0 +1,95 @@
+#ifndef __QPARSER_FROZENTOKENREGISTRY_H__
+#define __QPARSER_FROZENTOKENREGISTRY_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    FROZENTOKENREGISTRY.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      An immutable snapshot of a token registry (see TokenRegistry::Freeze).
+      A snapshot is reference counted and may be shared by any number of
+      parsers and threads without locking.
+
+    IMPLEMENTATION:
+      + The names of all terminals and nonterminals are copied into a
+        compact arena (temporary tokens that were never resolved are left
+        out). Tokens are mapped to their names by dense arrays of offsets,
+        as in TokenRegistry.
+      + Names are mapped to tokens by two perfect hash tables (see
+        KeywordHash), so that a lookup takes a single hash and a single
+        comparison. If no perfect hash is found for the names, they are
+        looked up by a binary search of the tokens sorted by name instead.
+      + Names returned by GetTokenName remain valid for the lifetime of the
+        snapshot.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class FrozenTokenRegistry
+  {
+  public:
+    // Construction
+    INLINE FrozenTokenRegistry(const TokenRegistry& tokenRegistry);
+    INLINE FrozenTokenRegistry(const FrozenTokenRegistry&) = delete;
+
+    // Look up the next available terminal token (at the time the registry was frozen)
+    INLINE ParseToken GetNextAvailableTerminal() const { return nextTerminalToken; }
+
+    // Look up the next available nonterminal token (at the time the registry was frozen)
+    INLINE ParseToken GetNextAvailableNonterminal() const { return nextNonterminalToken; }
+
+    // Get a token by the name used to identify it
+    INLINE ParseToken GetToken(const_cstring tokenName) const;
+    INLINE ParseToken GetToken(const_cstring tokenName, uint nameLength) const;
+
+    // Get a terminal token by the name used to identify it
+    INLINE ParseToken GetTerminal(const_cstring terminalName) const;
+    INLINE ParseToken GetTerminal(const_cstring terminalName, uint nameLength) const;
+
+    // Get a non-terminal token by the name used to identify it
+    INLINE ParseToken GetNonterminal(const_cstring nonterminalName) const;
+    INLINE ParseToken GetNonterminal(const_cstring nonterminalName, uint nameLength) const;
+
+    // Get the name corresponding to a specific token by token value
+    INLINE const_cstring GetTokenName(ParseToken token) const;
+
+    // Test whether a token is a terminal token (as opposed to a non-terminal)
+    static INLINE bool IsTerminal(ParseToken token) { return TokenRegistry::IsTerminal(token); }
+
+    // Test whether a token is a nonterminal token (as opposed to a terminal)
+    static INLINE bool IsNonterminal(ParseToken token) { return TokenRegistry::IsNonterminal(token); }
+
+    // Check whether a token is valid
+    INLINE bool IsTokenValid(ParseToken token) const;
+    INLINE bool IsTerminalValid(ParseToken terminal) const;
+    INLINE bool IsNonterminalValid(ParseToken nonterminal) const;
+
+  protected:
+    ParseToken nextTerminalToken;         // The next available terminal token
+    ParseToken nextNonterminalToken;      // The next available nonterminal token
+
+    std::vector<char> names;              // Concatenation of all token names (each followed by a null character)
+    std::vector<uint32> terminalNames;    // Offsets of the terminal names in the arena (indexed by token - TOKEN_TERMINAL_FIRST)
+    std::vector<uint32> nonterminalNames; // Offsets of the non-terminal names in the arena (indexed by token - TOKEN_NONTERMINAL_FIRST)
+    KeywordHash terminalTokens;           // All terminals by name (indexed by token - TOKEN_TERMINAL_FIRST)
+    KeywordHash nonterminalTokens;        // All non-terminals by name (indexed by token - TOKEN_NONTERMINAL_FIRST)
+    std::vector<uint32> terminalOrder;    // The indices of the terminals sorted by name (only if terminalTokens could not be built)
+    std::vector<uint32> nonterminalOrder; // The indices of the non-terminals sorted by name (only if nonterminalTokens could not be built)
+
+    // Copy the names of a range of tokens into the arena and build a hash table of them (or sort them if no hash table is found)
+    INLINE void FreezeNames(const TokenRegistry& tokenRegistry, ParseToken firstToken, ParseToken endToken, std::vector<uint32>& tokenNames, KeywordHash& tokens, std::vector<uint32>& tokenOrder);
+
+    // Look up the index of a name among a range of tokens (returns KeywordHash::INDEX_NONE if there is no token with the name)
+    INLINE KeywordHash::Index FindName(const std::vector<uint32>& tokenNames, const KeywordHash& tokens, const std::vector<uint32>& tokenOrder, const_cstring name, uint nameLength) const;
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "frozentokenregistry.inl"
+
+#endif
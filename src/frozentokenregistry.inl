@@ -0,0 +1,168 @@
+#ifdef  __QPARSER_FROZENTOKENREGISTRY_H__
+#ifndef __QPARSER_FROZENTOKENREGISTRY_INL__
+#define __QPARSER_FROZENTOKENREGISTRY_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    FROZENTOKENREGISTRY.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  INLINE FrozenTokenRegistry::FrozenTokenRegistry(const TokenRegistry& tokenRegistry) :
+    nextTerminalToken(tokenRegistry.GetNextAvailableTerminal()),
+    nextNonterminalToken(tokenRegistry.GetNextAvailableNonterminal())
+  {
+    names.reserve(tokenRegistry.namesLength);
+    FreezeNames(tokenRegistry, TOKEN_TERMINAL_FIRST, nextTerminalToken, terminalNames, terminalTokens, terminalOrder);
+    FreezeNames(tokenRegistry, TOKEN_NONTERMINAL_FIRST, nextNonterminalToken, nonterminalNames, nonterminalTokens, nonterminalOrder);
+    names.shrink_to_fit();
+  }
+
+  INLINE void FrozenTokenRegistry::FreezeNames(const TokenRegistry& tokenRegistry, ParseToken firstToken, ParseToken endToken, std::vector<uint32>& tokenNames, KeywordHash& tokens, std::vector<uint32>& tokenOrder)
+  {
+    std::vector<uint> lengths;
+    tokenNames.reserve(endToken - firstToken);
+    lengths.reserve(endToken - firstToken);
+    for(ParseToken token = firstToken; token < endToken; ++token)
+    {
+      const_cstring name = tokenRegistry.GetTokenName(token);
+      const uint length = (uint)strlen(name);
+      tokenNames.push_back((uint32)names.size());
+      lengths.push_back(length);
+      names.insert(names.end(), name, name + length + 1);
+    }
+
+    // (The arena no longer grows once the names are copied, so the keywords can refer to it)
+    std::vector<const_cstring> keywords(tokenNames.size());
+    for(uint c = 0; c < tokenNames.size(); ++c)
+      keywords[c] = &names[tokenNames[c]];
+    if(tokens.Build(keywords, lengths))
+      return;
+
+    // Sort the tokens by name instead
+    tokenOrder.resize(tokenNames.size());
+    for(uint c = 0; c < tokenOrder.size(); ++c)
+      tokenOrder[c] = c;
+    std::sort(tokenOrder.begin(), tokenOrder.end(), [&](uint32 a, uint32 b) { return strcmp(&names[tokenNames[a]], &names[tokenNames[b]]) < 0; });
+  }
+
+  INLINE KeywordHash::Index FrozenTokenRegistry::FindName(const std::vector<uint32>& tokenNames, const KeywordHash& tokens, const std::vector<uint32>& tokenOrder, const_cstring name, uint nameLength) const
+  {
+    if(!tokens.IsEmpty())
+      return tokens.Find(name, nameLength);
+
+    // (A name that starts with the given characters but continues beyond them compares greater than them)
+    std::vector<uint32>::const_iterator i = std::lower_bound(tokenOrder.begin(), tokenOrder.end(), name,
+      [&](uint32 index, const_cstring name) { return strncmp(&names[tokenNames[index]], name, nameLength) < 0; });
+    if(i == tokenOrder.end() || strncmp(&names[tokenNames[*i]], name, nameLength) != 0 || names[tokenNames[*i] + nameLength] != '\0')
+      return KeywordHash::INDEX_NONE;
+    return *i;
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetToken(const_cstring tokenName) const
+  {
+    return GetToken(tokenName, (uint)strlen(tokenName));
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetToken(const_cstring tokenName, uint nameLength) const
+  {
+    // Try to find a terminal token with this name
+    ParseToken token = GetTerminal(tokenName, nameLength);
+    if(token != ParseToken(-1))
+      return token;
+
+    // Try to find a non-terminal token with this name
+    return GetNonterminal(tokenName, nameLength);
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetTerminal(const_cstring terminalName) const
+  {
+    return GetTerminal(terminalName, (uint)strlen(terminalName));
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetTerminal(const_cstring terminalName, uint nameLength) const
+  {
+    KeywordHash::Index index = FindName(terminalNames, terminalTokens, terminalOrder, terminalName, nameLength);
+    return index == KeywordHash::INDEX_NONE? ParseToken(-1) : TOKEN_TERMINAL_FIRST + index;
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetNonterminal(const_cstring nonterminalName) const
+  {
+    return GetNonterminal(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken FrozenTokenRegistry::GetNonterminal(const_cstring nonterminalName, uint nameLength) const
+  {
+    KeywordHash::Index index = FindName(nonterminalNames, nonterminalTokens, nonterminalOrder, nonterminalName, nameLength);
+    return index == KeywordHash::INDEX_NONE? ParseToken(-1) : TOKEN_NONTERMINAL_FIRST + index;
+  }
+
+  INLINE const_cstring FrozenTokenRegistry::GetTokenName(ParseToken token) const
+  {
+    if(IsTerminal(token))
+    {
+      if(token >= TOKEN_TERMINAL_FIRST && token < nextTerminalToken)
+        return &names[terminalNames[token - TOKEN_TERMINAL_FIRST]];
+    }
+    else if(token < nextNonterminalToken)
+      return &names[nonterminalNames[token - TOKEN_NONTERMINAL_FIRST]];
+
+    // Special and unknown tokens
+    return TokenRegistry::GetSpecialTokenName(token);
+  }
+
+  INLINE bool FrozenTokenRegistry::IsTokenValid(ParseToken token) const
+  {
+    return IsTerminal(token)? token < nextTerminalToken : token < nextNonterminalToken;
+  }
+
+  INLINE bool FrozenTokenRegistry::IsTerminalValid(ParseToken terminal) const
+  {
+    return IsTerminal(terminal) && terminal < nextTerminalToken;
+  }
+
+  INLINE bool FrozenTokenRegistry::IsNonterminalValid(ParseToken nonterminal) const
+  {
+    return !IsTerminal(nonterminal) && nonterminal < nextNonterminalToken;
+  }
+
+  INLINE std::shared_ptr<const FrozenTokenRegistry> TokenRegistry::Freeze() const
+  {
+    // (Unresolved temporary tokens are left out of a snapshot. The names of a base snapshot are copied into a new snapshot as well,
+    //  so that it does not depend on the base.)
+    if(baseRegistry && nextTerminalToken == baseTerminalToken && nextNonterminalToken == baseNonterminalToken)
+      return baseRegistry;
+    return std::make_shared<const FrozenTokenRegistry>(*this);
+  }
+
+  INLINE void TokenRegistry::SetBase(const std::shared_ptr<const FrozenTokenRegistry>& baseRegistry)
+  {
+    // (Tokens registered before the base would take the values of the base's tokens)
+    OSI_ASSERT(IsEmpty() && !TokenRegistry::baseRegistry);
+
+    TokenRegistry::baseRegistry = baseRegistry;
+    nextTerminalToken = baseTerminalToken = baseRegistry->GetNextAvailableTerminal();
+    nextNonterminalToken = baseNonterminalToken = baseRegistry->GetNextAvailableNonterminal();
+  }
+
+  INLINE ParseToken TokenRegistry::FindBaseTerminal(const_cstring name, uint length) const
+  {
+    return baseRegistry? baseRegistry->GetTerminal(name, length) : ParseToken(-1);
+  }
+
+  INLINE ParseToken TokenRegistry::FindBaseNonterminal(const_cstring name, uint length) const
+  {
+    return baseRegistry? baseRegistry->GetNonterminal(name, length) : ParseToken(-1);
+  }
+
+  INLINE const_cstring TokenRegistry::GetBaseTokenName(ParseToken token) const
+  {
+    return baseRegistry? baseRegistry->GetTokenName(token) : GetSpecialTokenName(token);
+  }
+}
+
+#endif
+#endif
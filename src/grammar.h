@@ -17,6 +17,10 @@
         LL / LR / LARL class grammars etc.)
 
     IMPLEMENTATION:
+      + The tokens of all production rules are stored in a single array
+        with an array of offsets to the first token of each rule (a
+        compressed sparse row layout). The production sets are stored in a
+        dense array indexed by nonterminal.
       + Root tables (e.g. lexRootIndices, nilTokensRootIndices, etc) list
         indexes into their respective token parse table. An index of 255
         indicates no token.
@@ -67,22 +71,34 @@ namespace QParser
     virtual ~Grammar();
 
     // Productions
+    // (names may be given with their length, in which case they need not be null terminated)
     ParseToken BeginProduction(const_cstring productionName);
+    ParseToken BeginProduction(const_cstring productionName, uint nameLength);
     void EndProduction();
 
     void ProductionToken(ParseToken token);
     ParseToken ProductionToken(const_cstring tokenName);
+    ParseToken ProductionToken(const_cstring tokenName, uint nameLength);
     ParseToken ProductionIdentifierDecl(const_cstring typeName);
     //void ProductionIdentifierRef(OSid type);
     ParseToken ProductionIdentifierRef(const_cstring typeName);
 
     ParseToken DeclareProduction(const_cstring productionName);
+    ParseToken DeclareProduction(const_cstring productionName, uint nameLength);
 
     void Precedence(const_cstring token1Name, const_cstring token2Name);
+    void Precedence(const_cstring token1Name, uint name1Length, const_cstring token2Name, uint name2Length);
     void Precedence(ParseToken token1, ParseToken token2);
 
     void GrammarStartSymbol(ParseToken nonterminal);
 
+    // Mark a terminal as silent (it is not output by the parser)
+    void SilentTerminal(ParseToken terminal);
+
+    // Split the silent terminals into those that no production rule uses (nilTerminals; these can be discarded by the lexer)
+    // and those that the parser must still shift (maskedTerminals)
+    void ClassifySilentTerminals(TerminalSet& nilTerminals, TerminalSet& maskedTerminals) const;
+
     bool CheckForwardDeclarations() const;
     
     // Tokens
@@ -99,48 +115,44 @@ namespace QParser
 #endif*/
 
   protected:
-    // Production rules (which produce nonterminals)
+    // A production rule (which produces a nonterminal), referring to its tokens in the grammar's rule token array
     struct ProductionRule
     {
-      ParseToken* tokens;
-      uint8 tokensLength;
-      FORCE_INLINE ProductionRule() : tokens(null), tokensLength(0) {}
+      const ParseToken* tokens;
+      uint tokensLength;
     };
 
     // A production set is the set of productions producing the same nonterminal token
     struct ProductionSet
     {
       uint rulesOffset;   // Offset of the rules contained matching this production
-      uint8 rulesLength;  // Number of rules matching this production
+      uint rulesLength;   // Number of rules matching this production (0 if the nonterminal has no productions)
       bool nullable;      // Flag indicating whether any of the rules matching this production may be produced from an empty string
-      uint8 visitedCount; // A counter used for when determining whether this set is nullable
       FORCE_INLINE ProductionSet() : 
         rulesOffset(0), 
         rulesLength(0), 
-        nullable(false), 
-        visitedCount(0) {}
+        nullable(false) {}
     };
     
     // Container types
     typedef std::vector<ParseToken> ParseTokens;                                  // A list of parse tokens
-    typedef std::map<ParseToken, ProductionSet*> ProductionSets;                  // A grouping of productions mapped to the nonterminals that they produce
-    typedef std::vector< std::pair<ProductionRule, ParseToken> > ProductionRules; // A list of production rules together with the nonterminal that each produces
+    typedef std::vector<ProductionSet> ProductionSets;                            // The productions of every nonterminal (indexed by nonterminal - TOKEN_NONTERMINAL_FIRST)
     typedef std::multimap<ParseToken, ParseToken> PrecedenceMap;                  // A map which indicates how shift-reduce errors should be resolved (by giving one of the two tokens precedence)
     typedef std::set<ParseToken> ParseTokenSet;                                   // A unique set of tokens
     
     // Members
     TokenRegistry& tokenRegistry;       // A registry of the tokens used by both the parser and the lexer
-    ProductionSets productionSets;      // A mapping of all production sets from the nonterminal they produce
-    ProductionRules rules;              // All production rules in the grammar
-    ProductionRule* activeRule;         // A reference to the production rule that is currently being used (or constructed)
-    ParseTokens activeProductionTokens; // A list of the tokens inside a production which is currently being used
+    ProductionSets productionSets;      // The production sets of all nonterminals
+    ParseTokens ruleTokens;             // The tokens of all production rules (the rules' tokens follow each other in the order of the rules)
+    std::vector<uint> ruleOffsets;      // The offset of each rule's tokens in ruleTokens (followed by the end of the last complete rule)
+    ParseTokens ruleNonterminals;       // The nonterminal that each production rule produces
     PrecedenceMap precedenceMap;        // A map which indicates how shift-reduce errors should be resolved (by giving one of the two tokens precedence)
-    ParseTokenSet silentTerminals;      // Terminals which should not be output by the parser (or Lexer?? todo: resolve)
+    ParseTokenSet silentTerminals;      // Terminals which should not be output by the parser (see ClassifySilentTerminals)
     ParseToken rootNonterminal;         // The nonterminal which should be used to identify the root of the grammar used to build the parser (this nonterminal will also be the root of the produced tree)
 
     // Grammar construction operations  
     // Construct a non-terminal token
-    ParseToken ConstructNonterminal(const_cstring tokenName);
+    ParseToken ConstructNonterminal(const_cstring tokenName, uint nameLength);
     
     // Replace all tokens 
     void ReplaceAllTokens(ParseToken oldToken, ParseToken newToken);
@@ -159,9 +171,14 @@ namespace QParser
     const ProductionSet* GetProductionSet(ParseToken nonterminal) const;
           ProductionSet* GetProductionSet(ParseToken nonterminal);
     
+    // Get the number of production rules
+    uint GetRuleCount() const;
+
     // Get the production rule identified by its index
-    const ProductionRule& GetRule(uint index) const;
-          ProductionRule& GetRule(uint index);
+    ProductionRule GetRule(uint index) const;
+
+    // Get the nonterminal produced by a production rule identified by its index
+    ParseToken GetRuleNonterminal(uint index) const;
           
     // Get a token in a production rule identified by the rule index and the token index
     ParseToken GetRuleToken(uint ruleIndex, uint tokenIndex) const;
@@ -13,7 +13,7 @@ namespace QParser
 {
   Grammar::Grammar(TokenRegistry& tokenRegistry) :
     tokenRegistry(tokenRegistry),
-    activeRule(null),
+    ruleOffsets(1, 0),
     rootNonterminal(-1)
   {
   }
@@ -52,7 +52,7 @@ namespace QParser
 
           // Copy construction token into active tokens array
           // todo: this is rather ugly and inefficient... we should rewrite this using some indexing library
-          TokenRootIndex& tokenRootIndex = activeTokenRootIndices[uint(rootCharacter)];
+          TokenRootIndex& tokenRootIndex = activeTokenRootIndices[uint8(rootCharacter)];
           if(tokenRootIndex.length == 0)
           {
             tokenRootIndex.offset = cToken;
@@ -81,62 +81,56 @@ namespace QParser
 
   // Rules
   ParseToken Grammar::BeginProduction(const_cstring productionName)
+  {
+    return BeginProduction(productionName, (uint)strlen(productionName));
+  }
+
+  ParseToken Grammar::BeginProduction(const_cstring productionName, uint nameLength)
   {
     // Construct a nonterminal token for this production (if none exists)
-    ParseToken token = ConstructNonterminal(productionName);
+    ParseToken token = ConstructNonterminal(productionName, nameLength);
 
     // Get a production set
-    ProductionSet *productionSet = null;
     {
-      std::map<ParseToken, ProductionSet*>::iterator i = productionSets.find(token);
-      if(i == productionSets.end() || i->first != token)
-      {
-        productionSet = new ProductionSet();
-        productionSets[token] = productionSet;
-        productionSet->rulesOffset = rules.size();
-        productionSet->rulesLength = 1;
-      }
-      else
-      {
-        productionSet = i->second;
-        ++productionSet->rulesLength;
-      }
-      OSI_ASSERT(productionSet != null);
+      const uint index = token - TOKEN_NONTERMINAL_FIRST;
+      if(index >= productionSets.size())
+        productionSets.resize(tokenRegistry.GetNextAvailableNonterminal() - TOKEN_NONTERMINAL_FIRST);
+      ProductionSet& productionSet = productionSets[index];
+      if(productionSet.rulesLength == 0)
+        productionSet.rulesOffset = GetRuleCount();
+      ++productionSet.rulesLength;
     }
 
-    // Add a rule to a production
-    {
-      rules.push_back(std::make_pair(ProductionRule(), token));
-      activeRule = &rules[rules.size()-1].first;
-    }
+    // Add a rule to a production (its tokens are added to the end of ruleTokens until EndProduction)
+    OSI_ASSERT(ruleOffsets.size() == ruleNonterminals.size() + 1);
+    ruleNonterminals.push_back(token);
 
     return token;
   }
 
   void Grammar::EndProduction()
   {
-    // Add symbols to production rule
-    if (activeProductionTokens.size() > 0)
-    {
-      activeRule->tokens = new ParseToken[activeProductionTokens.size()];
-      activeRule->tokensLength = activeProductionTokens.size();
-      memcpy(activeRule->tokens, &activeProductionTokens[0], activeProductionTokens.size() * sizeof(ParseToken));
-      activeProductionTokens.clear();
-    }
-    activeRule = null;
+    // Close the rule's range of tokens
+    OSI_ASSERT(ruleOffsets.size() == ruleNonterminals.size());
+    ruleOffsets.push_back((uint)ruleTokens.size());
   }
 
   void Grammar::ProductionToken(ParseToken token)
   {
     OSI_ASSERT(tokenRegistry.IsTemporaryToken(token) || tokenRegistry.IsTokenValid(token));
-    activeProductionTokens.push_back(token);
+    ruleTokens.push_back(token);
   }
 
   ParseToken Grammar::ProductionToken(const_cstring tokenName)
   {
-    ParseToken token = tokenRegistry.GetToken(tokenName);
+    return ProductionToken(tokenName, (uint)strlen(tokenName));
+  }
+
+  ParseToken Grammar::ProductionToken(const_cstring tokenName, uint nameLength)
+  {
+    ParseToken token = tokenRegistry.GetToken(tokenName, nameLength);
     if(token == ParseToken(-1))
-      token = DeclareProduction(tokenName);
+      token = DeclareProduction(tokenName, nameLength);
     ProductionToken(token);
     return token;
   }
@@ -149,7 +143,7 @@ namespace QParser
     return typeHash;*/
     
     // todo: BUSY HERE... (REWRITE)
-    activeProductionTokens.push_back(TOKEN_TERMINAL_IDENTIFIER);
+    ruleTokens.push_back(TOKEN_TERMINAL_IDENTIFIER);
     return TOKEN_TERMINAL_IDENTIFIER;
   }
 
@@ -169,19 +163,29 @@ namespace QParser
     return typeHash;*/
     
     // todo: BUSY HERE... (REWRITE)
-    activeProductionTokens.push_back(TOKEN_TERMINAL_IDENTIFIER);
+    ruleTokens.push_back(TOKEN_TERMINAL_IDENTIFIER);
     return TOKEN_TERMINAL_IDENTIFIER;
   }
 
   ParseToken Grammar::DeclareProduction(const_cstring productionName)
   {
-    return tokenRegistry.FindOrGenerateTemporaryNonterminal(productionName);
+    return DeclareProduction(productionName, (uint)strlen(productionName));
+  }
+
+  ParseToken Grammar::DeclareProduction(const_cstring productionName, uint nameLength)
+  {
+    return tokenRegistry.FindOrGenerateTemporaryNonterminal(productionName, nameLength);
   }
 
   void Grammar::Precedence(const_cstring token1Name, const_cstring token2Name)
   {
-    ParseToken token1 = tokenRegistry.GetToken(token1Name);
-    ParseToken token2 = tokenRegistry.GetToken(token2Name);
+    Precedence(token1Name, (uint)strlen(token1Name), token2Name, (uint)strlen(token2Name));
+  }
+
+  void Grammar::Precedence(const_cstring token1Name, uint name1Length, const_cstring token2Name, uint name2Length)
+  {
+    ParseToken token1 = tokenRegistry.GetToken(token1Name, name1Length);
+    ParseToken token2 = tokenRegistry.GetToken(token2Name, name2Length);
     if(token1 != ParseToken(-1) && token2 != ParseToken(-1))
       Precedence(token1, token2);
     //else error: incorrect ids
@@ -198,6 +202,32 @@ namespace QParser
     rootNonterminal = nonterminal;
   }
 
+  void Grammar::SilentTerminal(ParseToken terminal)
+  {
+    OSI_ASSERT(TokenRegistry::IsTerminal(terminal));
+    silentTerminals.insert(terminal);
+  }
+
+  void Grammar::ClassifySilentTerminals(TerminalSet& nilTerminals, TerminalSet& maskedTerminals) const
+  {
+    nilTerminals.Clear();
+    maskedTerminals.Clear();
+
+    // Find the silent terminals used by production rules
+    ParseTokenSet usedTerminals;
+    for(ParseTokens::const_iterator i = ruleTokens.begin(); i != ruleTokens.end(); ++i)
+      if(IsSilent(*i))
+        usedTerminals.insert(*i);
+
+    for(ParseTokenSet::const_iterator i = silentTerminals.begin(); i != silentTerminals.end(); ++i)
+    {
+      if(usedTerminals.find(*i) != usedTerminals.end())
+        maskedTerminals.Add(*i);
+      else
+        nilTerminals.Add(*i);
+    }
+  }
+
   bool Grammar::CheckForwardDeclarations() const
   {
     bool success = true;
@@ -244,7 +274,7 @@ namespace QParser
     return token;
   }*/
   
-  ParseToken Grammar::ConstructNonterminal(const_cstring tokenName)
+  ParseToken Grammar::ConstructNonterminal(const_cstring tokenName, uint nameLength)
   {
     /*ParseToken token = -1;
     // Try to find an existing nonterminal token with this name
@@ -276,37 +306,30 @@ namespace QParser
     
     // TODO: BUSY HERE (rewriting this)
     
-    ParseToken token = tokenRegistry.GetToken(tokenName);
+    ParseToken token = tokenRegistry.GetToken(tokenName, nameLength);
     
     // If the token is a temporary token, we need to substitute it with a new
     // token and replace all instances where the token was used with the proper
     // value
     if(tokenRegistry.IsTemporaryToken(token))
     {
-      ParseToken newToken = tokenRegistry.ResolveTemporaryToken(tokenName);
+      ParseToken newToken = tokenRegistry.ResolveTemporaryToken(tokenName, nameLength);
       ReplaceAllTokens(token, newToken);
       return newToken;
     }
     // If the token does not exist yet, we generate one
     else if(token == ParseToken(-1))
     {
-      token = tokenRegistry.GenerateNonterminal(tokenName);
+      token = tokenRegistry.GenerateNonterminal(tokenName, nameLength);
     }    
     return token;    
   }
   
   INLINE void Grammar::ReplaceAllTokens(ParseToken oldToken, ParseToken newToken)
   {
-    for(std::vector< std::pair<ProductionRule, ParseToken> >::iterator i = rules.begin(); i != rules.end(); ++i)
-    {
-      ProductionRule& rule = i->first;
-      
-      for(uint c = 0; c < rule.tokensLength; ++c)
-      {
-        if(rule.tokens[c] == oldToken)
-          rule.tokens[c] = newToken;
-      }
-    }
+    for(ParseTokens::iterator i = ruleTokens.begin(); i != ruleTokens.end(); ++i)
+      if(*i == oldToken)
+        *i = newToken;
   }
 
   INLINE bool Grammar::IsSilent(const ProductionRule& rule) const
@@ -333,33 +356,39 @@ namespace QParser
   
   INLINE const Grammar::ProductionSet* Grammar::GetProductionSet(ParseToken nonterminal) const
   {
-    std::map<ParseToken, ProductionSet*>::const_iterator i = productionSets.find(nonterminal);
-    if(i == productionSets.end() || i->first != nonterminal)
+    const ParseToken index = nonterminal - TOKEN_NONTERMINAL_FIRST;
+    if(index >= productionSets.size() || productionSets[index].rulesLength == 0)
       return null;
-    return i->second;
+    return &productionSets[index];
   }
 
   INLINE Grammar::ProductionSet* Grammar::GetProductionSet(ParseToken nonterminal)
   {
-    std::map<ParseToken, ProductionSet*>::iterator i = productionSets.find(nonterminal);
-    if(i == productionSets.end() || i->first != nonterminal)
+    const ParseToken index = nonterminal - TOKEN_NONTERMINAL_FIRST;
+    if(index >= productionSets.size() || productionSets[index].rulesLength == 0)
       return null;
-    return i->second;
+    return &productionSets[index];
   }
-  
-  INLINE const Grammar::ProductionRule& Grammar::GetRule(uint index) const
+
+  INLINE uint Grammar::GetRuleCount() const
   {
-    return rules[index].first;
+    return (uint)ruleNonterminals.size();
   }
   
-  INLINE Grammar::ProductionRule& Grammar::GetRule(uint index)
+  INLINE Grammar::ProductionRule Grammar::GetRule(uint index) const
+  {
+    ProductionRule rule = { ruleTokens.data() + ruleOffsets[index], ruleOffsets[index + 1] - ruleOffsets[index] };
+    return rule;
+  }
+
+  INLINE ParseToken Grammar::GetRuleNonterminal(uint index) const
   {
-    return rules[index].first;
+    return ruleNonterminals[index];
   }
   
   INLINE ParseToken Grammar::GetRuleToken(uint ruleIndex, uint tokenIndex) const
   {
-    return rules[ruleIndex].first.tokens[tokenIndex];
+    return ruleTokens[ruleOffsets[ruleIndex] + tokenIndex];
   }
 
 /*#ifdef _DEBUG
@@ -25,6 +25,9 @@ namespace QParser
       else 
         rootNonterminal = tokenRegistry.GetNextAvailableNonterminal() - 1; // Use the last defined nonterminal our root nonterminal
     }
+
+    // Compute the nullable nonterminals and the FIRST sets (all productions are defined by now)
+    ComputeFirstTerminals();
     
     // Construct the the parser
     // Get the start items
@@ -393,7 +396,7 @@ namespace QParser
       else
         copyItemsSubset[c] = false;
     }
-    OSI_ASSERT(!rules.empty()); // Post-condition: at least one rule must reference the pivot terminal
+    OSI_ASSERT(GetRuleCount() > 0); // Post-condition: at least one rule must reference the pivot terminal
     
     // Include items in the copy subset if their input position rule refers to any of the rules already in the subset
     bool copySubsetChanged; // A flag indicating that the copy subset changed (grew during this iteration). The loop is terminated once it can no longer grow.
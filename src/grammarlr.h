@@ -12,6 +12,14 @@
     DESCRIPTION:
       A base class for LR class grammars.
 
+    IMPLEMENTATION:
+      + Nullable and FIRST are computed once for all nonterminals (see
+        ComputeFirstTerminals). Nullable is found by a worklist over the
+        number of symbols in each rule not yet known to be nullable. FIRST
+        sets are dense terminal bitsets which are propagated along the
+        "FIRST(A) contains FIRST(B)" edges of the grammar by a worklist
+        until they no longer change. Queries are then word-parallel unions.
+
     REFERENCES:
       + [modcomp]
         title = "Modern Compiler Implementation in Java, Second Edition"
@@ -78,17 +86,25 @@ namespace QParser
     
     States states;              // The set of all of the states in the parsing table
     ItemStateMap itemStateMap;  // A map of what state each item maps to (for quick lookup)
+    std::vector<TerminalSet> firstTerminalSets; // The FIRST set of every nonterminal (indexed by nonterminal - TOKEN_NONTERMINAL_FIRST, see ComputeFirstTerminals)
 
     // Get all initial items for productions that produce a certain non-terminal symbol
     void GetStartItems(ParseToken nonterminal, Items& items);
 
-    // Get the first set of terminals for some token id. Returns true if the set is nullable.
-    // todo: we'll remove the bool and instead just store nullable directly in the productionSet
-    bool GetFirstTerminals(ParseToken token, ParseTokenSet& firstTerminals);
+    // Compute the nullable flag (in the production sets) and the FIRST set of all nonterminals
+    // (this is done when the construction of the parse table starts, once all productions are defined, and must precede the queries below)
+    void ComputeFirstTerminals();
+
+    // Test whether a token can be produced from an empty string
+    bool IsNullable(ParseToken token) const;
+
+    // Add the first set of terminals for some token id to a set. Returns true if the token is nullable.
+    bool GetFirstTerminals(ParseToken token, TerminalSet& firstTerminals) const;
     
-    // Get an item's lookahead terminal symbols (all possible terminals that can follow after the current input position)
-    // including -1 if no terminal is a possibility (i.e. end-of-stream)
-    void GetLookaheadTerminals(const Item& item, ParseTokenSet& lookaheadTerminals);
+    // Add an item's lookahead terminal symbols (all possible terminals that can follow after the current input position) to a set.
+    // Returns true if the rest of the item's rule is nullable, in which case the item's own lookahead can follow as well
+    // (this may be end-of-stream, which is not a terminal in the set)
+    bool GetLookaheadTerminals(const Item& item, TerminalSet& lookaheadTerminals) const;
 
     // Find the state (index) that an item belongs to. Returns -1 if the item does not exist yet.
     int FindItemState(const Item& items);
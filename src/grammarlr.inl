@@ -41,70 +41,142 @@ namespace QParser
   }
 
   template<typename Item, typename State>
-  INLINE bool GrammarLR<Item, State>::GetFirstTerminals(ParseToken token, ParseTokenSet& firstTerminals)
+  INLINE void GrammarLR<Item, State>::ComputeFirstTerminals()
   {
-    if(TokenRegistry::IsTerminal(token))
+    const uint nNonterminals = tokenRegistry.GetNextAvailableNonterminal() - TOKEN_NONTERMINAL_FIRST;
+    std::vector<ParseToken> worklist;
+
+    //// Nullable
+    // Count the symbols of every rule not yet known to be nullable and index the rules in which each nonterminal occurs
+    std::vector<uint> nonnullableCounts(GetRuleCount());
+    std::vector< std::vector<uint> > nonterminalRules(nNonterminals);
+    for(auto i = productionSets.begin(); i != productionSets.end(); ++i)
+      i->nullable = false;
+    for(uint cRule = 0; cRule < GetRuleCount(); ++cRule)
     {
-      firstTerminals.insert(token);
-      return false;  // FIRST(id) is not nullable
+      const ProductionRule rule = GetRule(cRule);
+      nonnullableCounts[cRule] = rule.tokensLength;
+      for(uint cToken = 0; cToken < rule.tokensLength; ++cToken)
+        if(TokenRegistry::IsNonterminal(rule.tokens[cToken]))
+          nonterminalRules[rule.tokens[cToken] - TOKEN_NONTERMINAL_FIRST].push_back(cRule);
+      if(rule.tokensLength == 0)
+      {
+        ProductionSet& productionSet = *GetProductionSet(GetRuleNonterminal(cRule));
+        if(!productionSet.nullable)
+        {
+          productionSet.nullable = true;
+          worklist.push_back(GetRuleNonterminal(cRule));
+        }
+      }
     }
 
-    // Initialize the nullable attribute
-    ProductionSet& productionSet = *GetProductionSet(token);
-    ++productionSet.visitedCount;
-
-    if(productionSet.visitedCount > 1)
-      return productionSet.nullable;
-
-    // Get first items
-    for(uint c = 0; c < productionSet.rulesLength; ++c)
+    // Every nonterminal that becomes nullable makes the rules in which it occurs one symbol closer to nullable
+    while(!worklist.empty())
     {
-      const ProductionRule& rule = rules[productionSet.rulesOffset + c].first;
-      bool productionNullable = true;
+      const std::vector<uint>& occurrences = nonterminalRules[worklist.back() - TOKEN_NONTERMINAL_FIRST];
+      worklist.pop_back();
+      for(uint c = 0; c < occurrences.size(); ++c)
+      {
+        if(--nonnullableCounts[occurrences[c]] != 0)
+          continue;
+        ParseToken nonterminal = GetRuleNonterminal(occurrences[c]);
+        ProductionSet& productionSet = *GetProductionSet(nonterminal);
+        if(!productionSet.nullable)
+        {
+          productionSet.nullable = true;
+          worklist.push_back(nonterminal);
+        }
+      }
+    }
 
+    //// FIRST
+    // Add the terminals that begin a rule (after a nullable prefix) directly and record which FIRST sets contain which others
+    std::vector< std::vector<ParseToken> > dependentNonterminals(nNonterminals); // The nonterminals whose FIRST sets contain the FIRST set of each nonterminal
+    firstTerminalSets.assign(nNonterminals, TerminalSet());
+    for(uint cRule = 0; cRule < GetRuleCount(); ++cRule)
+    {
+      const ProductionRule rule = GetRule(cRule);
+      const ParseToken nonterminal = GetRuleNonterminal(cRule);
       for(uint cToken = 0; cToken < rule.tokensLength; ++cToken)
       {
-        productionNullable &= GetFirstTerminals(rule.tokens[cToken], firstTerminals);
-        if(!productionNullable)
+        const ParseToken token = rule.tokens[cToken];
+        if(TokenRegistry::IsTerminal(token))
+        {
+          firstTerminalSets[nonterminal - TOKEN_NONTERMINAL_FIRST].Add(token);
+          break;
+        }
+        if(token != nonterminal)
+          dependentNonterminals[token - TOKEN_NONTERMINAL_FIRST].push_back(nonterminal);
+        if(!IsNullable(token))
           break;
       }
+    }
 
-      // If the production set's nullity changes and the production set is recursive, we must restart the process with the new nullity value
-      if((productionNullable || rule.tokensLength == 0) && productionSet.nullable == false)
+    // Propagate the FIRST sets until none of them change
+    std::vector<bool> queued(nNonterminals, false);
+    for(uint c = 0; c < nNonterminals; ++c)
+      if(!firstTerminalSets[c].IsEmpty() && !dependentNonterminals[c].empty())
       {
-        // Note: If getFirstTerminals is called on productionSet for the first time, its nullity MUST be false.
-        //       It can change to true during evaluation of this function, but can never return to false.
-        //       If the nullity of the nonterminal changes and the nonterminals is recursive (visited count becomes > 1
-        //       during evaluation of its sub tokens), the function must be restarted using the new nullity value
-        //       (which must then be true since we can't return to false).
-        //       Also note that we don't need to restore the firstTerminals to its previous state since, we can only
-        //       add more terminals by making this nonterminal nullable.
-
-        productionSet.nullable = true;
-        productionSet.visitedCount = 0;
-        return GetFirstTerminals(token, firstTerminals);
+        worklist.push_back(TOKEN_NONTERMINAL_FIRST + c);
+        queued[c] = true;
+      }
+    while(!worklist.empty())
+    {
+      const uint index = worklist.back() - TOKEN_NONTERMINAL_FIRST;
+      worklist.pop_back();
+      queued[index] = false;
+
+      const std::vector<ParseToken>& dependents = dependentNonterminals[index];
+      for(uint c = 0; c < dependents.size(); ++c)
+      {
+        const uint dependentIndex = dependents[c] - TOKEN_NONTERMINAL_FIRST;
+        if(firstTerminalSets[dependentIndex].Union(firstTerminalSets[index]) && !queued[dependentIndex] && !dependentNonterminals[dependentIndex].empty())
+        {
+          worklist.push_back(dependents[c]);
+          queued[dependentIndex] = true;
+        }
       }
     }
+  }
 
-    // Reset the visited count (since this is the first evaluation of the production set)
-    productionSet.visitedCount = 0;
+  template<typename Item, typename State>
+  INLINE bool GrammarLR<Item, State>::IsNullable(ParseToken token) const
+  {
+    if(TokenRegistry::IsTerminal(token))
+      return false; // FIRST(id) is not nullable
+    const ProductionSet* productionSet = GetProductionSet(token);
+    return productionSet != null && productionSet->nullable;
+  }
+
+  template<typename Item, typename State>
+  INLINE bool GrammarLR<Item, State>::GetFirstTerminals(ParseToken token, TerminalSet& firstTerminals) const
+  {
+    if(TokenRegistry::IsTerminal(token))
+    {
+      firstTerminals.Add(token);
+      return false;
+    }
 
-    return productionSet.nullable;
+    // (The FIRST sets are only known once ComputeFirstTerminals has run)
+    const uint index = token - TOKEN_NONTERMINAL_FIRST;
+    OSI_ASSERT(index < firstTerminalSets.size());
+    if(index < firstTerminalSets.size())
+      firstTerminals.Union(firstTerminalSets[index]);
+    return IsNullable(token);
   }
 
   template<typename Item, typename State>
-  INLINE void GrammarLR<Item, State>::GetLookaheadTerminals(const Item& item, ParseTokenSet& lookaheadTerminals)
+  INLINE bool GrammarLR<Item, State>::GetLookaheadTerminals(const Item& item, TerminalSet& lookaheadTerminals) const
   {
-    const ProductionRule& rule = rules[item.ruleIndex].first;
+    const ProductionRule rule = GetRule(item.ruleIndex);
     for(uint cToken = item.inputPosition + 1; cToken < rule.tokensLength; ++cToken)
     {
       if(!GetFirstTerminals(rule.tokens[cToken], lookaheadTerminals))
-        return; // The symbol (terminal / nonterminal) is not nullable, so we're done
+        return false; // The symbol (terminal / nonterminal) is not nullable, so we're done
     }
 
-    // Add the lookahead symbol of the parent item if all other items are nullable
-    // (this might be -1 for no lookahead)
-    lookaheadTerminals.insert(item.lookaheadSymbol);
+    // The lookahead of the parent item follows if all other tokens are nullable
+    return true;
   }
 
   template<typename Item, typename State>
@@ -0,0 +1,89 @@
+#ifndef __QPARSER_KEYWORDHASH_H__
+#define __QPARSER_KEYWORDHASH_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    KEYWORDHASH.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A perfect hash table used by the lexer to look up keywords (lex words)
+      with a single hash and a single string comparison.
+
+    IMPLEMENTATION:
+      + The hash is keyed on the length of a word and a few sampled
+        characters (the first two, the middle and the last two). If two
+        keywords cannot be told apart by their samples, all characters of
+        the word are hashed instead.
+      + The table is built using "hash and displace": Keywords are first
+        hashed into small buckets and each bucket is then assigned a
+        displacement that moves all of its keywords into free slots of the
+        table.
+      + The search for a seed is bounded. If two distinct keywords hash to
+        the same 64-bit key, or no seed places every bucket, the table is
+        left empty and the caller looks its keywords up some other way.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class KeywordHash
+  {
+  public:
+    // Index of a keyword (in the order in which the keywords were given to Build)
+    typedef uint32 Index;
+    static const Index INDEX_NONE = ~Index(0);
+
+    // Construction
+    INLINE KeywordHash();
+
+    // Remove all keywords
+    INLINE void Clear();
+
+    // Build the table for the given keywords (a keyword that occurs more than once maps to its first index)
+    // Returns false if no perfect hash was found for the keywords, in which case the table is left empty.
+    INLINE bool Build(const std::vector<const_cstring>& keywords, const std::vector<uint>& lengths);
+
+    // Look up the index of a keyword (returns INDEX_NONE if the word is not a keyword)
+    FORCE_INLINE Index Find(const_cstring word, uint length) const;
+
+    //// Accessors
+    INLINE bool IsEmpty() const { return slots.empty(); }
+    INLINE bool IsSampled() const { return sampled; }
+
+  protected:
+    static const uint32 MAX_DISPLACEMENT = 1 << 16; // The largest displacement tried for a bucket
+    static const uint64 MAX_SEED = 64;              // The number of seeds tried before giving up
+
+    // A slot in the table
+    struct Slot
+    {
+      Index index;      // The keyword's index (INDEX_NONE if the slot is empty)
+      uint32 offset;    // Offset of the keyword's characters
+      uint32 length;    // Length of the keyword
+    };
+
+    std::vector<Slot> slots;            // The table (a power of two in size)
+    std::vector<uint32> displacements;  // The displacement of every bucket (a power of two in size)
+    std::vector<char> characters;       // Concatenation of all keywords
+    uint32 slotMask;                    // Mask used to find a slot from a hash
+    uint32 bucketMask;                  // Mask used to find a bucket from a hash
+    uint64 seed;                        // Seed of the hash function
+    bool sampled;                       // Flag indicating that keywords are hashed by their sampled characters
+
+    // Hash functions
+    static FORCE_INLINE uint64 Mix(uint64 value);
+    FORCE_INLINE uint64 Key(const_cstring word, uint length) const;
+    FORCE_INLINE uint64 Hash(const_cstring word, uint length) const { return Mix(Key(word, length) ^ seed); }
+    FORCE_INLINE uint32 GetBucket(uint64 hash) const { return uint32(hash >> 32) & bucketMask; }
+    FORCE_INLINE uint32 GetSlot(uint64 hash, uint32 displacement) const { return uint32(Mix(hash + displacement)) & slotMask; }
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "keywordhash.inl"
+
+#endif
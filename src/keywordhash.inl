@@ -0,0 +1,193 @@
+#ifdef  __QPARSER_KEYWORDHASH_H__
+#ifndef __QPARSER_KEYWORDHASH_INL__
+#define __QPARSER_KEYWORDHASH_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    KEYWORDHASH.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  const KeywordHash::Index KeywordHash::INDEX_NONE;
+  const uint32 KeywordHash::MAX_DISPLACEMENT;
+  const uint64 KeywordHash::MAX_SEED;
+
+  INLINE KeywordHash::KeywordHash()
+  {
+    Clear();
+  }
+
+  INLINE void KeywordHash::Clear()
+  {
+    slots.clear();
+    displacements.clear();
+    characters.clear();
+    slotMask = 0;
+    bucketMask = 0;
+    seed = 0;
+    sampled = true;
+  }
+
+  INLINE bool KeywordHash::Build(const std::vector<const_cstring>& keywords, const std::vector<uint>& lengths)
+  {
+    Clear();
+
+    // Remove duplicate keywords (keeping the first occurrence) and copy the characters of the remaining ones
+    std::vector<Slot> entries;
+    {
+      std::set<std::string> uniqueKeywords;
+      for(uint c = 0; c < keywords.size(); ++c)
+      {
+        if(!uniqueKeywords.insert(std::string(keywords[c], lengths[c])).second)
+          continue;
+
+        Slot entry;
+        entry.index = c;
+        entry.offset = (uint32)characters.size();
+        entry.length = lengths[c];
+        characters.insert(characters.end(), keywords[c], keywords[c] + lengths[c]);
+        entries.push_back(entry);
+      }
+    }
+    if(entries.empty())
+      return true;
+    characters.push_back('\0'); // (so that &characters[0] is always valid)
+
+    // Hash the sampled characters only if they tell all keywords apart
+    {
+      std::set<uint64> keys;
+      for(uint c = 0; c < entries.size() && sampled; ++c)
+        sampled = keys.insert(Key(&characters[entries[c].offset], entries[c].length)).second;
+      if(!sampled)
+      {
+        keys.clear();
+        for(uint c = 0; c < entries.size(); ++c)
+          if(!keys.insert(Key(&characters[entries[c].offset], entries[c].length)).second)
+          {
+            // (64-bit collision between two distinct keywords: no seed can tell them apart)
+            Clear();
+            return false;
+          }
+      }
+    }
+
+    // Size the table at twice the number of keywords with buckets of two keywords on average
+    uint nSlots = 1;
+    while(nSlots < 2 * entries.size())
+      nSlots *= 2;
+    uint nBuckets = 1;
+    while(nBuckets * 2 < entries.size())
+      nBuckets *= 2;
+    slotMask = nSlots - 1;
+    bucketMask = nBuckets - 1;
+
+    // Search for a seed for which every bucket can be displaced into free slots
+    for(seed = 0; seed < MAX_SEED; ++seed)
+    {
+      // Distribute the keywords among the buckets
+      std::vector< std::vector<uint> > buckets(nBuckets);
+      std::vector<uint64> hashes(entries.size());
+      for(uint c = 0; c < entries.size(); ++c)
+      {
+        hashes[c] = Hash(&characters[entries[c].offset], entries[c].length);
+        buckets[GetBucket(hashes[c])].push_back(c);
+      }
+
+      // Place the largest buckets first
+      std::vector<uint> bucketOrder(nBuckets);
+      for(uint c = 0; c < nBuckets; ++c)
+        bucketOrder[c] = c;
+      std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](uint a, uint b) { return buckets[a].size() > buckets[b].size(); });
+
+      Slot emptySlot = { INDEX_NONE, 0, 0 };
+      slots.assign(nSlots, emptySlot);
+      displacements.assign(nBuckets, 0);
+
+      bool success = true;
+      for(uint cBucket = 0; cBucket < nBuckets && success; ++cBucket)
+      {
+        const std::vector<uint>& bucket = buckets[bucketOrder[cBucket]];
+        if(bucket.empty())
+          break;
+
+        // Find a displacement that moves every keyword in the bucket to a distinct free slot
+        uint32 displacement;
+        std::vector<uint32> bucketSlots(bucket.size());
+        for(displacement = 0; displacement < MAX_DISPLACEMENT; ++displacement)
+        {
+          bool free = true;
+          for(uint c = 0; c < bucket.size() && free; ++c)
+          {
+            bucketSlots[c] = GetSlot(hashes[bucket[c]], displacement);
+            free = (slots[bucketSlots[c]].index == INDEX_NONE) && std::find(bucketSlots.begin(), bucketSlots.begin() + c, bucketSlots[c]) == bucketSlots.begin() + c;
+          }
+          if(free)
+            break;
+        }
+
+        if(displacement == MAX_DISPLACEMENT)
+        {
+          success = false;
+          break;
+        }
+
+        displacements[bucketOrder[cBucket]] = displacement;
+        for(uint c = 0; c < bucket.size(); ++c)
+          slots[bucketSlots[c]] = entries[bucket[c]];
+      }
+
+      if(success)
+        return true;
+    }
+
+    Clear();
+    return false;
+  }
+
+  FORCE_INLINE KeywordHash::Index KeywordHash::Find(const_cstring word, uint length) const
+  {
+    const uint64 hash = Hash(word, length);
+    const Slot& slot = slots[GetSlot(hash, displacements[GetBucket(hash)])];
+    if(slot.length != length || memcmp(&characters[slot.offset], word, length) != 0)
+      return INDEX_NONE;
+    return slot.index;
+  }
+
+  FORCE_INLINE uint64 KeywordHash::Mix(uint64 value)
+  {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+  }
+
+  FORCE_INLINE uint64 KeywordHash::Key(const_cstring word, uint length) const
+  {
+    if(sampled)
+    {
+      // The length and five sampled characters
+      if(length == 0)
+        return 0;
+      return (uint64(length) << 40)
+        ^ (uint64(uint8(word[0])) << 32)
+        ^ (uint64(uint8(word[length > 1? 1 : 0])) << 24)
+        ^ (uint64(uint8(word[length / 2])) << 16)
+        ^ (uint64(uint8(word[length > 1? length - 2 : 0])) << 8)
+        ^ uint64(uint8(word[length - 1]));
+    }
+
+    // All characters (FNV-1a)
+    uint64 key = 14695981039346656037ULL;
+    for(uint c = 0; c < length; ++c)
+      key = (key ^ uint8(word[c])) * 1099511628211ULL;
+    return key ^ length;
+  }
+}
+
+#endif
+#endif
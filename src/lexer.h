@@ -12,6 +12,68 @@
     DESCRIPTION:
       QParser's simple lexer
 
+    IMPLEMENTATION:
+      + All raw tokens, nil tokens and lex symbols (including regular
+        expression tokens) are compiled into a single deterministic automaton
+        (see LexerDFA) so that each input position is matched in one pass
+        instead of one scan per token type. Matching never backtracks: each
+        attempt reads every character once. (A pattern such as "a+b" may
+        still read a long run of characters before it fails to match.)
+      + Lex words (keywords) are looked up through a perfect hash (see
+        KeywordHash) so that classifying a word costs one hash and one string
+        comparison.
+      + Runs of word characters and runs of whitespace (characters that can
+        only ever match a single character nil token) are skipped with the
+        vectorized character class scans of CharScan.
+      + Inputs followed by enough zero padding (see GetInputPadding) are
+        lexed without bounds checks: No token contains a zero character, so
+        the automaton always stops at the padding, and the closing
+        boundaries of bounded tokens are compared 8 characters at a time.
+      + Identifiers can be interned into a SymbolTable. This happens in a
+        single pass over the finished lex stream (rather than on the threads
+        that lex parts of the input) so that symbol ids are assigned in the
+        order in which identifiers first occur.
+      + Numeric literals can be decoded (see NumericLiteral). Each literal is
+        decoded on the thread that lexes it, right after the word is
+        classified, while its characters are still in the cache. A literal
+        whose '.' or exponent sign is a separate lex symbol is decoded once
+        the tokens it spans have been lexed. (Only the few tokens around the
+        points where the parts of the input are joined are decoded again.)
+      + Large inputs can be lexed on several threads (see SetThreadCount).
+        The input is split after newlines and each part is lexed on its own
+        thread as if a new token starts there. Parts for which this turns
+        out to be false (e.g. a comment spans the split) are lexed again
+        sequentially until their tokens coincide with the part's tokens.
+      + Edited inputs can be lexed incrementally (see IncrementalAnalysis).
+        Lexing restarts at a token before the line of the edit that was
+        matched without reading the edited characters and stops as soon as
+        a token coincides with a token of the previous lex stream, in the
+        same way as the parts lexed on separate threads are resynchronized.
+      + Tokens can also be lexed one at a time on demand of the parser (see
+        ContextualAnalysis and ParserLD::Parse), trying only the terminals
+        that the parser can accept next. Acceptable lex symbols take
+        precedence over the others (so "<<" may be lexed as "<" followed by
+        "<") and lex words that are not acceptable are lexed as identifiers
+        (e.g. a keyword may be used as a name). Lex words still end at any
+        symbol token.
+      + Silent terminals that the grammar does not use are lexed as nil
+        tokens, so neither the lex stream nor the recognizer sees them. The
+        silent terminals that the grammar does use are flagged in a mask
+        with one bit per token (see SetSilentTerminals).
+      + The lexer is byte-clean: characters are always indexed as unsigned
+        bytes, and bytes beyond ASCII (which no token starts with unless one
+        is defined to) are part of lex words, so identifiers may contain
+        multi-byte UTF-8 sequences.
+      + The input can be validated as UTF-8 (see ParseResult::validateUtf8
+        and CharScan::FindInvalidUtf8) in the same pass: Validation runs
+        in blocks of a few kilobytes just ahead of the parse position, so
+        the lexer reads the characters the validator just read, from the
+        cache.
+      + The start of every line can be recorded in a LineIndex in the same
+        pass: Like validation, the newlines are found in blocks just ahead
+        of the parse position (on the thread that lexes the part of the
+        input), so the input is never scanned for lines separately.
+
     TODO:
       + The lexer should eventually be implemented in a separate library,
         but we will just separate it in this class for the time being.
@@ -33,8 +95,9 @@ namespace QParser
       TOKENTYPE_LEX_WORD   = 3
     };
     
-    // Construction
+    // Construction / Destruction
     INLINE Lexer(TokenRegistry& tokenRegistry);
+    INLINE ~Lexer();
     
     // Add a string token to the lexer definition
     INLINE ParseToken StringToken(const_cstring tokenName, const_cstring value);
@@ -45,19 +108,172 @@ namespace QParser
     // Add a bounded token (With start and end characters) to the lexer definition
     INLINE ParseToken BoundedToken(const_cstring tokenName, const_cstring leftBoundingValue, const_cstring rightBoundingValue, OSIX::PARSER_BOUNDED_LINETYPE lineType);
     
+    // Add a regular expression token to the lexer definition (see Regex for the syntax). A regular expression token matches
+    // the longest input that it can, and takes precedence over the string and bounded tokens of the same type.
+    INLINE ParseToken RegexToken(const_cstring tokenName, const_cstring pattern);
+
     // Build the lexer definition so that it can be used for lexical analysis
     INLINE void Build(TokenType tokenType);
     
+    // State carried over between calls to LexicalAnalysis when the input is lexed in parts
+    // (Describes the progress of a bounded token whose closing boundary has not been found yet)
+    struct ResumeState
+    {
+      ParseOffset tokenOffset;          // Offset of the token (relative to the first unconsumed character)
+      LexerDFA::Candidate candidate;    // The bounded token being matched (CANDIDATE_NONE if there is none)
+      ParseOffset searchOffset;         // Offset (relative to the token) from which to continue searching for the closing boundary
+
+      INLINE ResumeState() : tokenOffset(0), candidate(LexerDFA::CANDIDATE_NONE), searchOffset(0) {}
+    };
+
+    // Get the bounded token that a resume state is matching and the length of its opening boundary. Returns false unless the
+    // characters between the token's opening boundary and the search offset are never read again once lexing resumes (in which
+    // case they may be discarded, provided the offsets and lengths of the matches that follow are corrected for them).
+    INLINE bool GetTrimmableToken(const ResumeState& resumeState, ParseToken& token, TokenType& tokenType, ParseOffset& openingLength) const;
+
+    // Set the terminals that the parser does not output (see Grammar::ClassifySilentTerminals). Silent raw tokens and lex symbols in
+    // nilTerminals are lexed as nil tokens, so they never reach the lex stream. The other silent tokens are still lexed, but flagged in
+    // the silent mask of the parse result.
+    INLINE void SetSilentTerminals(const TerminalSet& nilTerminals, const TerminalSet& maskedTerminals);
+
+    // Set the number of threads used to lex large inputs (0 uses one thread per processor)
+    INLINE void SetThreadCount(uint nThreads);
+
     // Perform the lexical analysis on the parser input (inputs a character stream 
     // and produces a lex stream)
-    INLINE void LexicalAnalysis(ParseResult& parseResult);
+    // (If the parse result has a symbol table, identifiers are interned into it and a symbol stream is produced as well.
+    //  If decodeLiterals is set, the values of numeric literals are decoded into a literal stream.
+    //  If the parse result has a line index, the start of every line is recorded in it.
+    //  If there are silent terminals, the silent mask of the parse result is filled in.)
+    INLINE void LexicalAnalysis(ParseResult& parseResult) const;
+
+    // Flag the silent tokens of the lex stream of the parse result in its silent mask
+    INLINE void MaskSilentTokens(ParseResult& parseResult) const;
+
+    // Perform the lexical analysis on the input, writing the lex stream directly into the given buffer
+    // (The buffer is cleared first; it may use memory provided by the caller or be reused for many inputs)
+    INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, MatchBuffer& tokenMatches) const;
+
+    // Perform the lexical analysis on an input that is followed by inputPadding zero characters
+    // (If the padding is at least GetInputPadding() characters long, the input is lexed without bounds checks)
+    INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches) const;
+
+    // Perform the lexical analysis on an input that is followed by inputPadding zero characters, recording the start of every
+    // line in lineIndex as well (the index is cleared first; null if lines should not be indexed)
+    INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex) const;
+
+    // Perform the lexical analysis on an input that is followed by inputPadding zero characters, validating the input as UTF-8 in the
+    // same pass. invalidUtf8Offset receives the offset of the first invalid UTF-8 sequence, or inputLength if the input is valid (null
+    // if the input should not be validated).
+    INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset) const;
+
+    // Lex an edited input again, updating the lex stream of the input before the edit (tokenMatches) in place. The edit
+    // replaced removedLength characters at editOffset by insertedLength characters; input holds the input after the edit.
+    // Only the input around the edit is lexed again, up to the first token that coincides with a previous token. The
+    // offsets of the previous tokens beyond it are shifted by the change in length.
+    INLINE void IncrementalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset editOffset, ParseOffset removedLength, ParseOffset insertedLength, MatchBuffer& tokenMatches) const;
+
+    // Perform the lexical analysis of the next token from position onwards, preferring the raw tokens and lex symbols in
+    // acceptableTerminals (the token with the highest precedence is only lexed if none of them match). Nil tokens are always skipped
+    // and lex words that are not acceptable are lexed as identifiers or literals. Position is advanced past the token. Returns false
+    // if no tokens remain. inputPadding is the number of zero characters that follow the input.
+    INLINE bool ContextualAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset& position, const TerminalSet& acceptableTerminals, ParseMatch& tokenMatch) const;
+
+    // Intern the identifiers among the lexical tokens, storing the symbol of every token in symbols (SYMBOL_NONE for tokens that are not identifiers)
+    INLINE void InternIdentifiers(const_cstring input, const ParseMatch* tokenMatches, ParseOffset nTokenMatches, SymbolTable& symbolTable, SymbolTable::SymbolId* symbols) const;
+
+    // Decode the numeric literals among the lexical tokens, storing the value of every token in literals (LITERALTYPE_NONE for tokens
+    // that are not literals). A real number whose '.' or exponent sign is a separate lex symbol spans several tokens; its value
+    // is stored with the first of them. (LexicalAnalysis decodes the literals of a parse result while lexing; this decodes those of a
+    // lex stream produced by one of the other overloads.)
+    INLINE void DecodeLiterals(const_cstring input, ParseOffset inputLength, const ParseMatch* tokenMatches, ParseOffset nTokenMatches, NumericLiteral* literals) const;
+
+    // Get the number of zero characters that must follow the input for it to be lexed without bounds checks
+    INLINE ParseOffset GetInputPadding() const { return inputPadding; }
+
+    // Perform the lexical analysis on a part of the input, appending the matches to tokenMatches (with inputOffset added to
+    // their offsets). Lexing stops at the first token that starts at or beyond splitLength. If the input is not final,
+    // lexing also stops at the first token that may still change once more input is available. Returns the number of
+    // characters consumed; the remaining characters must be passed in again (followed by more input) together with the
+    // returned resume state. inputPadding is the number of zero characters that follow the input (it only applies to
+    // final input).
+    INLINE ParseOffset LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches) const;
+
+    // Perform the lexical analysis on a part of the input (as above), validating the input up to splitLength as UTF-8 as well. The
+    // offset of the first invalid UTF-8 sequence is stored in invalidUtf8Offset (it is left unchanged if the input is valid).
+    INLINE ParseOffset LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches, ParseOffset* invalidUtf8Offset) const;
     
   protected:
+    // Perform the lexical analysis on the whole input (as above), decoding the numeric literals into literals as well (the buffer
+    // is cleared first and receives one value per token; null if literals should not be decoded)
+    INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset, LiteralBuffer* literals) const;
+
+    // Perform the lexical analysis on a part of the input (as above), adding the lines that start up to splitLength to lineIndex (null if
+    // lines should not be indexed) and appending the value of every token to literals as well (null if literals should not be decoded).
+    // literals must hold one value per token of tokenMatches. The input must be final.
+    INLINE ParseOffset LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset, LiteralBuffer* literals) const;
+
+    // State of the numeric literals decoded while lexing
+    struct LiteralState
+    {
+      LiteralBuffer* literals;                // The value of every token lexed so far
+      const_cstring input;                    // The start of the input (the offsets of the tokens are relative to it)
+      const_cstring inputEnd;                 // The end of the input
+      ParseOffset pendingLiteral;             // The token of a literal that may span the tokens that follow it
+      const_cstring pendingLiteralEnd;        // The furthest end of the literals decoded since the pending literal (null if there is none)
+    };
+
+    // Decode the value of the token that was just appended to tokenMatches
+    // (A literal that reaches beyond its token remains pending until a token that it cannot span is lexed)
+    INLINE void DecodeLiteral(const MatchBuffer& tokenMatches, LiteralState& literalState) const;
+
+    // Decode the pending literal (and the tokens that follow it up to nTokenMatches) once no more tokens can be part of it
+    INLINE void DecodePendingLiteral(const MatchBuffer& tokenMatches, ParseOffset nTokenMatches, LiteralState& literalState) const;
+
+    // Decode the literals of the tokens around the given token again after the tokens before it were lexed separately from it
+    // (e.g. by another thread)
+    INLINE void DecodeLiteralsAround(const_cstring input, ParseOffset inputLength, const MatchBuffer& tokenMatches, NumericLiteral* literals, ParseOffset index) const;
+
     TokenRegistry& tokenRegistry; // A reference to the token registry used by both the lexer and the parser
+
+    // Multi-threaded lexing
+    static const ParseOffset MIN_THREAD_INPUT_LENGTH = 1024 * 1024; // The smallest part of the input worth lexing on a separate thread
+    uint nThreads;                                                  // Number of threads used to lex the input
+
+    // The expected number of input characters per lexical token (used to estimate the size of the lex stream)
+    static const ParseOffset ESTIMATED_CHARACTERS_PER_MATCH = 4;
+
+    // Padded input
+    static const ParseOffset MIN_INPUT_PADDING = 16;  // The smallest padding required (allows the closing boundaries of bounded tokens to be compared 8 characters at a time)
+    ParseOffset inputPadding;                         // The padding required (at least the length of the longest symbol token)
+
+    // UTF-8 validation
+    static const ParseOffset UTF8_VALIDATION_BLOCK_LENGTH = 4096; // The number of characters validated ahead of the parse position at a time
+
+    // Validate the input from validatedEnd up to a block beyond the parse position (returns the end of the validated input)
+    INLINE const_cstring ValidateUtf8(const_cstring input, ParseOffset inputOffset, const_cstring validatedEnd, const_cstring validationEnd, const_cstring parsePosition, ParseOffset& invalidUtf8Offset) const;
+
+    // Line indexing
+    static const ParseOffset LINE_INDEX_BLOCK_LENGTH = 4096; // The number of characters indexed ahead of the parse position at a time
+
+    // Index the lines of the input from indexedEnd up to a block beyond the parse position (returns the end of the indexed input)
+    INLINE const_cstring IndexLines(const_cstring input, ParseOffset inputOffset, const_cstring indexedEnd, const_cstring indexEnd, const_cstring parsePosition, LineIndex& lineIndex) const;
+
+    // Test whether an edit of the input may have completed the closing boundary of a multi-line bounded token
+    INLINE bool EditMayCloseBoundary(const_cstring input, ParseOffset inputLength, ParseOffset editOffset, ParseOffset insertedLength) const;
     
+    // The outcome of matching a token
+    enum MatchResult
+    {
+      MATCHRESULT_NONE       = 0, // The token does not match
+      MATCHRESULT_MATCH      = 1, // The token matches
+      MATCHRESULT_INCOMPLETE = 2  // The input ends before it can be determined whether the token matches
+    };
+
     // Special characters used in lexer token definitions
     static const char SPECIAL_SINGLELINE_BOUNDING_CHAR;
     static const char SPECIAL_MULTILINE_BOUNDING_CHAR;
+    static const char SPECIAL_REGEX_CHAR;
     
     std::set<ParseToken> lexTokens; // The set of tokens already contained in the lexer
     
@@ -66,10 +282,10 @@ namespace QParser
     struct LexMatch
     {
       ParseToken token;   // The lexical token
-      uint16 valueOffset; // Offset into the character stream
-      uint8  valueLength; // Length of the matched characters
+      uint32 valueOffset; // Offset into the character stream
+      uint16 valueLength; // Length of the matched characters
 
-      INLINE LexMatch(ParseToken token, uint16 valueOffset, uint8 valueLength) : token(token), valueOffset(valueOffset), valueLength(valueLength) {}
+      INLINE LexMatch(ParseToken token, uint32 valueOffset, uint16 valueLength) : token(token), valueOffset(valueOffset), valueLength(valueLength) {}
       INLINE LexMatch(const LexMatch& match) : token(match.token), valueOffset(match.valueOffset), valueLength(match.valueLength) {}
       INLINE LexMatch() {}
     };
@@ -95,8 +311,8 @@ namespace QParser
     // of the token)
     struct TokenRootIndex
     {
-      uint8 offset; // Offset of the first token in the token liste
-      uint8 length; // Number of tokens corresponding to the token root character
+      uint32 offset; // Offset of the first token in the token liste
+      uint32 length; // Number of tokens corresponding to the token root character
     };
 
     union
@@ -111,26 +327,61 @@ namespace QParser
       };
     };
 
+    // Symbol tokens (raw, nil and lex symbols) recognized by the symbol automaton. 
+    // The candidates are stored in order of precedence and are indexed by the candidate numbers accepted by the automaton.
+    struct SymbolCandidate
+    {
+      LexMatch token;     // The lexical token
+      TokenType type;     // The type of the token (raw, nil or lex symbol)
+      bool bounded;       // Flag indicating that the automaton only matches the token's opening boundary
+      uint64 closingPrefix; // The first (up to 8) characters of the closing boundary (bounded tokens only)
+      uint64 closingMask;   // Mask selecting the characters of closingPrefix
+      bool trimmable;       // Flag indicating that the token never reads its characters again after they were searched for its closing boundary (see GetTrimmableToken)
+    };
+    std::vector<SymbolCandidate> symbolCandidates;  // All symbol tokens in order of precedence
+    LexerDFA symbolAutomaton;                       // Combined automaton recognizing all symbol tokens (and bounded token openers)
+    CharClass blankClass;                           // Characters that always match a single character nil token (e.g. whitespace)
+    CharClass nonBlankClass;                        // The complement of blankClass (used to skip runs of blank characters)
+
+    // Silent terminals (see SetSilentTerminals)
+    TerminalSet silentNilTerminals;                 // Silent terminals lexed as nil tokens (lex words among them are flagged instead)
+    TerminalSet silentMaskedTerminals;              // Silent terminals flagged in the silent mask
+
+    // Perfect hash of all lex words (used instead of the root index once there are enough lex words)
+    static const uint MIN_KEYWORD_HASH_LENGTH = 8;  // The smallest number of lex words worth hashing
+    KeywordHash keywordHash;                        // Maps lex words to their indices in lexWordTokens
+
     // Data structures used during construction of the lexer
     typedef std::vector<LexMatch> TokenConstructionSet; // An array of lex matches used during construction
     TokenConstructionSet constructionTokens;            // Tokens array used during construction (Indexed by token value)
     
-    std::vector<ParseMatch> constructMatches; // construction set for parse matches
-    
     // Add a lex token to the lexer if it does not already exists
     INLINE void AddLexToken(ParseToken token, uint bufferLength, uint valueLength);
     
-    // 
-    INLINE bool ParseSymbolToken(TokenType tokenType, const_cstring inputPosition, uint inputLength, ParseMatch& tokenMatch) const;
+    // Rebuild the symbol automaton from all raw, nil and lex symbol tokens built so far
+    INLINE void BuildSymbolAutomaton();
+
+    // Rebuild the keyword hash from the lex word tokens
+    INLINE void BuildKeywordHash();
     
-    //
-    INLINE bool MatchSymbolToken(const LexMatch& token, const_cstring inputPosition, uint length, uint16& matchLength) const;
+    // Find a position at (or after) the given position where the input can be split between threads
+    INLINE ParseOffset FindSplit(const_cstring input, ParseOffset inputLength, ParseOffset position) const;
+
+    // Match the symbol token with the highest precedence at the input position
+    // (PADDED indicates that the input is final and followed by at least inputPadding zero characters)
+    // (If acceptableTerminals is not null, only nil tokens and the terminals it contains are matched)
+    template<bool PADDED> INLINE MatchResult MatchSymbol(const_cstring inputPosition, ParseOffset inputLength, bool final, ResumeState& resumeState, ParseMatch& tokenMatch, TokenType& tokenType, const TerminalSet* acceptableTerminals) const;
     
-    //
-    INLINE bool MatchBoundingToken(const LexMatch& token, const_cstring inputPosition, uint length, uint16& matchLength) const;
+    // Match a bounded token whose opening boundary (of length matchLength) has been matched already
+    // (searching for the closing boundary from searchOffset onwards)
+    template<bool PADDED> INLINE MatchResult MatchBoundingToken(const SymbolCandidate& candidate, const_cstring inputPosition, ParseOffset inputLength, bool final, ParseOffset& searchOffset, ParseLength& matchLength) const;
 
-    //
-    INLINE void ParseWordToken(const_cstring inputPosition, ParseMatch& tokenMatch) const;
+    // Compare the closing boundary of a bounded token against padded input
+    static FORCE_INLINE bool MatchPaddedBoundary(const SymbolCandidate& candidate, const_cstring inputPosition, const_cstring boundary, uint boundaryLength);
+
+    // Classify a lex word as a lex word token, an identifier or a literal
+    // (If acceptableTerminals is not null, lex words that it does not contain are classified as identifiers or literals)
+    INLINE void ParseWordToken(const_cstring inputPosition, ParseMatch& tokenMatch, const TerminalSet* acceptableTerminals) const;
     
     //
     INLINE bool MatchWordToken(const LexMatch& token, const_cstring inputPosition) const;
@@ -13,12 +13,33 @@ namespace QParser
 {
   const char Lexer::SPECIAL_SINGLELINE_BOUNDING_CHAR = '\0';
   const char Lexer::SPECIAL_MULTILINE_BOUNDING_CHAR = '\1';
+  const char Lexer::SPECIAL_REGEX_CHAR = '\2';
   
-  INLINE Lexer::Lexer(TokenRegistry& tokenRegistry) : tokenRegistry(tokenRegistry)
+  const ParseOffset Lexer::MIN_THREAD_INPUT_LENGTH;
+  const uint Lexer::MIN_KEYWORD_HASH_LENGTH;
+  const ParseOffset Lexer::ESTIMATED_CHARACTERS_PER_MATCH;
+  const ParseOffset Lexer::MIN_INPUT_PADDING;
+  const ParseOffset Lexer::UTF8_VALIDATION_BLOCK_LENGTH;
+  const ParseOffset Lexer::LINE_INDEX_BLOCK_LENGTH;
+
+  INLINE Lexer::Lexer(TokenRegistry& tokenRegistry) : tokenRegistry(tokenRegistry), nThreads(1), inputPadding(MIN_INPUT_PADDING)
   {
+    memset(tokens, 0, sizeof(tokens));
+    memset(nTokens, 0, sizeof(nTokens));
     memset(tokenRootIndices, 0, sizeof(tokenRootIndices)); 
   }
   
+  INLINE void Lexer::SetThreadCount(uint nThreads)
+  {
+    Lexer::nThreads = (nThreads == 0)? std::max(1u, std::thread::hardware_concurrency()) : nThreads;
+  }
+
+  INLINE Lexer::~Lexer()
+  {
+    for(uint c = 0; c < 4; ++c)
+      delete[] tokens[c];
+  }
+  
   ParseToken Lexer::StringToken(const_cstring tokenName, const_cstring value)
   {
     // Initialize variables
@@ -84,6 +105,26 @@ namespace QParser
     return token;
   }
   
+  ParseToken Lexer::RegexToken(const_cstring tokenName, const_cstring pattern)
+  {
+    const uint    patternLength    = (uint)strlen(pattern) + 1;
+    const uint    bufferLength     = (uint)tokenCharacters.size();
+
+    // Preconditions
+    OSI_ASSERT(Regex().Parse(pattern));
+
+    // Concatenate token pattern to token (character) storage buffer
+    tokenCharacters.resize(bufferLength + 1 + patternLength);
+    tokenCharacters[bufferLength] = SPECIAL_REGEX_CHAR; // special character (the first character is a regular expression indicator)
+    for(uint c = 0; c < patternLength; ++c)
+      tokenCharacters[bufferLength + 1 + c] = pattern[c];
+
+    // Create the terminal token and add it to all the relevant indexes
+    ParseToken token = tokenRegistry.GenerateTerminal(tokenName);
+    AddLexToken(token, bufferLength, 1 + patternLength);
+    return token;
+  }
+
   INLINE void Lexer::Build(TokenType tokenType)
   {
     uint&             nTokens                      = Lexer::nTokens[tokenType];
@@ -93,49 +134,170 @@ namespace QParser
     //// Consolidate tokens (Copy tokens to a fixed array & construct a root character index)
     // Allocate token array
     nTokens = (uint)constructionTokens.size();
+    delete[] activeTokens;
     activeTokens = new LexMatch[nTokens];
 
     // Clear token root indices
-    memset(activeTokenRootIndices, 0, sizeof(TokenRootIndex) * nTokens);
+    memset(activeTokenRootIndices, 0, sizeof(activeTokenRootIndices));
 
-    // Copy tokens to token array (ordered by their parse values)
+    // Copy tokens to token array, grouped by their root characters (a stable counting sort, so that tokens sharing a
+    // root character remain in the order in which they were defined)
     {
-      uint                           cToken;
-      TokenConstructionSet::iterator iToken;
+      // Find the root character of every token
+      std::vector<uint8> rootCharacters(nTokens);
+      for(uint cToken = 0; cToken < nTokens; ++cToken)
+      {
+        const LexMatch& token = constructionTokens[cToken];
+        char rootCharacter = tokenCharacters[token.valueOffset];
+        if(rootCharacter == SPECIAL_MULTILINE_BOUNDING_CHAR
+            || rootCharacter == SPECIAL_SINGLELINE_BOUNDING_CHAR)
+          rootCharacter = tokenCharacters[token.valueOffset + 1];
+        rootCharacters[cToken] = uint8(rootCharacter);
+        ++activeTokenRootIndices[rootCharacters[cToken]].length;
+      }
 
-      for(cToken = 0, iToken = constructionTokens.begin(); cToken < nTokens; ++cToken, ++iToken)
+      // Assign each root character its range of the token array
+      uint32 offset = 0;
+      for(uint c = 0; c <= MAX_UINT8; ++c)
       {
-        // Add to token "root character" indexing table (optimization index)
-        {
-          char rootCharacter = tokenCharacters[(*iToken).valueOffset];
-          if(rootCharacter == SPECIAL_MULTILINE_BOUNDING_CHAR
-              || rootCharacter == SPECIAL_SINGLELINE_BOUNDING_CHAR)
-            rootCharacter = tokenCharacters[(*iToken).valueOffset + 1];
-
-          // Copy construction token into active tokens array
-          // todo: this is rather ugly and inefficient... we should rewrite this using some indexing library
-          TokenRootIndex& tokenRootIndex = activeTokenRootIndices[uint(rootCharacter)];
-          if(tokenRootIndex.length == 0)
-          {
-            tokenRootIndex.offset = cToken;
-            activeTokens[tokenRootIndex.offset] = *iToken;
-          }
-          else
-          {
-            // (move all tokens up by one)
-            memmove(&activeTokens[tokenRootIndex.offset + tokenRootIndex.length + 1], &activeTokens[tokenRootIndex.offset + tokenRootIndex.length], sizeof(LexMatch[cToken - (tokenRootIndex.offset + tokenRootIndex.length)]));
-            for(uint c = 0; c <= MAX_UINT8; ++c)
-              if(activeTokenRootIndices[c].offset > tokenRootIndex.offset)
-                ++activeTokenRootIndices[c].offset;
-
-            // (inert token into this position)
-            activeTokens[tokenRootIndex.offset + tokenRootIndex.length] = *iToken;
-          }
+        activeTokenRootIndices[c].offset = offset;
+        offset += activeTokenRootIndices[c].length;
+      }
+
+      // Distribute the tokens among the ranges
+      std::vector<uint32> nextOffsets(MAX_UINT8 + 1);
+      for(uint c = 0; c <= MAX_UINT8; ++c)
+        nextOffsets[c] = activeTokenRootIndices[c].offset;
+      for(uint cToken = 0; cToken < nTokens; ++cToken)
+        activeTokens[nextOffsets[rootCharacters[cToken]]++] = constructionTokens[cToken];
+    }
+
+    // Clear construction tokens
+    constructionTokens.clear();
 
-          ++tokenRootIndex.length;
+    // Rebuild the combined automaton for all symbol tokens
+    if(tokenType != TOKENTYPE_LEX_WORD)
+      BuildSymbolAutomaton();
+    else
+      BuildKeywordHash();
+  }
+
+  INLINE void Lexer::BuildKeywordHash()
+  {
+    // (Small keyword sets are looked up just as quickly through the root index)
+    if(nTokens[TOKENTYPE_LEX_WORD] < MIN_KEYWORD_HASH_LENGTH)
+    {
+      keywordHash.Clear();
+      return;
+    }
+
+    std::vector<const_cstring> keywords(nTokens[TOKENTYPE_LEX_WORD]);
+    std::vector<uint> lengths(nTokens[TOKENTYPE_LEX_WORD]);
+    for(uint c = 0; c < nTokens[TOKENTYPE_LEX_WORD]; ++c)
+    {
+      keywords[c] = &tokenCharacters[lexWordTokens[c].valueOffset];
+      lengths[c] = lexWordTokens[c].valueLength - 1;
+    }
+    // (If no perfect hash is found, the table is left empty and the lex words are looked up through the root index)
+    keywordHash.Build(keywords, lengths);
+  }
+  
+  INLINE void Lexer::BuildSymbolAutomaton()
+  {
+    symbolCandidates.clear();
+    symbolAutomaton.Clear();
+
+    // Add all symbol tokens to the automaton in order of precedence (raw tokens, then nil tokens, then lex symbols)
+    // Note: Within each type, tokens sharing the same root character are kept in the order that they were defined.
+    //       The relative order of tokens with different root characters does not matter since they can never match
+    //       the same input. (Regular expressions are grouped under SPECIAL_REGEX_CHAR, so they precede the strings.)
+    for(uint tokenType = TOKENTYPE_RAW; tokenType <= TOKENTYPE_LEX_SYMBOL; ++tokenType)
+    {
+      for(uint cToken = 0; cToken < nTokens[tokenType]; ++cToken)
+      {
+        SymbolCandidate candidate;
+        candidate.token = tokens[tokenType][cToken];
+        candidate.type = silentNilTerminals.Contains(candidate.token.token)? TOKENTYPE_NIL : TokenType(tokenType);
+
+        // Bounded tokens are recognized by their opening boundary (which follows the boundedness indicator)
+        const_cstring value = &tokenCharacters[candidate.token.valueOffset];
+        candidate.bounded = (value[0] == SPECIAL_SINGLELINE_BOUNDING_CHAR || value[0] == SPECIAL_MULTILINE_BOUNDING_CHAR);
+        candidate.closingPrefix = 0;
+        candidate.closingMask = 0;
+        candidate.trimmable = false;
+        if(value[0] == SPECIAL_REGEX_CHAR)
+        {
+          // (Patterns are validated when the token is defined; an invalid pattern matches nothing)
+          Regex regex;
+          if(regex.Parse(value + 1))
+            symbolAutomaton.AddRegex(regex, LexerDFA::Candidate(symbolCandidates.size()));
+          symbolCandidates.push_back(candidate);
+          continue;
+        }
+        if(candidate.bounded)
+        {
+          ++value;
+
+          // Keep the first characters of the closing boundary (which follows the opening boundary) for comparing against padded input
+          const_cstring const closingValue = value + strlen(value) + 1;
+          const uint closingPrefixLength = std::min<uint>((uint)strlen(closingValue), 8);
+          const uint64 ones = ~uint64(0);
+          memcpy(&candidate.closingPrefix, closingValue, closingPrefixLength);
+          memcpy(&candidate.closingMask, &ones, closingPrefixLength);
         }
+
+        symbolAutomaton.AddString(value, (uint)strlen(value), LexerDFA::Candidate(symbolCandidates.size()));
+        symbolCandidates.push_back(candidate);
+      }
+    }
+
+    symbolAutomaton.Build();
+
+    // Find the multi-line bounded tokens whose characters are not read again when lexing resumes the search for their closing
+    // boundary: No bounded token with a higher precedence may be tried along the opening boundary (it would search the characters
+    // that follow as well) and no token with a higher precedence may be reachable beyond it (the automaton would continue reading)
+    // (A single-line token is never trimmable: It may still fail to match at the end of its line, so that its characters are lexed again)
+    for(uint c = 0; c < symbolCandidates.size(); ++c)
+    {
+      SymbolCandidate& candidate = symbolCandidates[c];
+      const_cstring const value = &tokenCharacters[candidate.token.valueOffset];
+      if(value[0] != SPECIAL_MULTILINE_BOUNDING_CHAR)
+        continue;
+
+      bool preempted = false;
+      LexerDFA::State state = LexerDFA::STATE_START;
+      for(const_cstring opening = value + 1; *opening != '\0'; ++opening)
+      {
+        state = symbolAutomaton.Transition(state, uint8(*opening));
+        for(const LexerDFA::Candidate* i = symbolAutomaton.AcceptBegin(state); i != symbolAutomaton.AcceptEnd(state) && *i < c; ++i)
+          preempted = preempted || symbolCandidates[*i].bounded;
       }
+      const LexerDFA::Candidate bestReachableCandidate = symbolAutomaton.GetBestReachableCandidate(state);
+      candidate.trimmable = !preempted && (bestReachableCandidate == LexerDFA::CANDIDATE_NONE || bestReachableCandidate > c);
+    }
+
+    // The padding must hold the longest symbol token plus the 8 characters read at once when comparing closing boundaries
+    // (Regular expressions never match the zero characters of the padding, so they need no padding of their own)
+    inputPadding = MIN_INPUT_PADDING;
+    for(uint c = 0; c < symbolCandidates.size(); ++c)
+      if(tokenCharacters[symbolCandidates[c].token.valueOffset] != SPECIAL_REGEX_CHAR)
+        inputPadding = std::max(inputPadding, (ParseOffset)symbolCandidates[c].token.valueLength + 8);
+
+    // Find the blank characters: The best token accepted after the character is a nil token that is not bounded and
+    // no token with a higher precedence (nor a longer match of the same regular expression) can be reached by reading further
+    blankClass.Clear();
+    for(uint c = 0; c <= MAX_UINT8; ++c)
+    {
+      const LexerDFA::State state = symbolAutomaton.Transition(LexerDFA::STATE_START, uint8(c));
+      if(state == LexerDFA::STATE_DEAD || symbolAutomaton.AcceptBegin(state) == symbolAutomaton.AcceptEnd(state))
+        continue;
+
+      const LexerDFA::Candidate best = *symbolAutomaton.AcceptBegin(state);
+      if(symbolCandidates[best].type == TOKENTYPE_NIL && !symbolCandidates[best].bounded && symbolAutomaton.GetBestReachableCandidate(state) > best)
+        blankClass.Add(uint8(c));
     }
+    nonBlankClass = blankClass;
+    nonBlankClass.Invert();
   }
   
   INLINE void Lexer::AddLexToken(ParseToken token, uint bufferLength, uint valueLength)
@@ -149,286 +311,953 @@ namespace QParser
     constructionTokens.push_back(LexMatch(token, bufferLength, valueLength));
   }
   
-  INLINE void Lexer::LexicalAnalysis(ParseResult& parseResult)
+  INLINE bool Lexer::GetTrimmableToken(const ResumeState& resumeState, ParseToken& token, TokenType& tokenType, ParseOffset& openingLength) const
   {
-    std::vector<ParseMatch>& tokenMatches = constructMatches;
-    const_cstring parsePosition        = parseResult.inputStream.data;
-    const_cstring lexWordStartPosition = parseResult.inputStream.data;
+    if(resumeState.candidate == LexerDFA::CANDIDATE_NONE || !symbolCandidates[resumeState.candidate].trimmable)
+      return false;
 
-    while(parsePosition < &parseResult.inputStream.data[parseResult.inputStream.length])
+    const SymbolCandidate& candidate = symbolCandidates[resumeState.candidate];
+    token = candidate.token.token;
+    tokenType = candidate.type;
+    openingLength = (ParseOffset)strlen(&tokenCharacters[candidate.token.valueOffset + 1]);
+    return true;
+  }
+
+  INLINE void Lexer::LexicalAnalysis(ParseResult& parseResult) const
+  {
+    // Lex directly into the memory of the lex stream
+    // (Numeric literals are decoded while lexing, directly into the memory of the literal stream)
+    MatchBuffer tokenMatches;
+    LiteralBuffer literals;
+    LexicalAnalysis(parseResult.inputStream.data, parseResult.inputStream.length, parseResult.inputPadding, tokenMatches, parseResult.lineIndex, parseResult.validateUtf8? &parseResult.invalidUtf8Offset : null, parseResult.decodeLiterals? &literals : null);
+
+    // (The memory is trimmed if the estimated size turned out to be much too large, see MatchBuffer::Release)
+    parseResult.lexStream.length = tokenMatches.GetLength();
+    parseResult.lexStream.data = tokenMatches.Release();
+
+    // Intern identifiers
+    if(parseResult.symbolTable != null)
     {
-      //bug: const uint remainingLength  = (uint)(&parseResult.inputData[parseResult.inputLength] - parsePosition);
-      const uint remainingLength  = (uint)(&parseResult.inputStream.data[parseResult.inputStream.length] - parsePosition + 1);
+      delete[] parseResult.symbolStream.data;
+      parseResult.symbolStream.length = parseResult.lexStream.length;
+      parseResult.symbolStream.elementSize = sizeof(SymbolTable::SymbolId);
+      parseResult.symbolStream.data = new SymbolTable::SymbolId[parseResult.lexStream.length];
+      InternIdentifiers(parseResult.inputStream.data, parseResult.lexStream.data, parseResult.lexStream.length, *parseResult.symbolTable, parseResult.symbolStream.data);
+    }
 
-      // Match raw token, nil token or lex symbol token (symbolic tokens that do not need to be seperated, such as operators)
-      ParseMatch tokenSymbolMatch;
-      tokenSymbolMatch.offset = (uint)(parsePosition - parseResult.inputStream.data);
+    // Store the numeric literals
+    if(parseResult.decodeLiterals)
+    {
+      delete[] parseResult.literalStream.data;
+      parseResult.literalStream.length = literals.GetLength();
+      parseResult.literalStream.elementSize = sizeof(NumericLiteral);
+      parseResult.literalStream.data = literals.Release();
+    }
+
+    // Flag silent tokens
+    MaskSilentTokens(parseResult);
+  }
+
+  INLINE void Lexer::SetSilentTerminals(const TerminalSet& nilTerminals, const TerminalSet& maskedTerminals)
+  {
+    silentNilTerminals = nilTerminals;
+    silentMaskedTerminals = maskedTerminals;
+
+    // Reclassify the symbol tokens built so far
+    BuildSymbolAutomaton();
+  }
+
+  INLINE void Lexer::MaskSilentTokens(ParseResult& parseResult) const
+  {
+    delete[] parseResult.silentMask.data;
+    parseResult.silentMask.data = null;
+    parseResult.silentMask.length = 0;
+    parseResult.silentMask.elementSize = sizeof(uint64);
+    if(silentNilTerminals.IsEmpty() && silentMaskedTerminals.IsEmpty())
+      return;
+
+    // (Silent lex words are never lexed as nil tokens, so they are flagged as well)
+    parseResult.silentMask.length = (parseResult.lexStream.length + 63) / 64;
+    parseResult.silentMask.data = new uint64[parseResult.silentMask.length];
+    memset(parseResult.silentMask.data, 0, parseResult.silentMask.length * sizeof(uint64));
+    for(ParseOffset c = 0; c < parseResult.lexStream.length; ++c)
+    {
+      const ParseToken token = parseResult.lexStream.data[c].token;
+      if(silentMaskedTerminals.Contains(token) || silentNilTerminals.Contains(token))
+        parseResult.silentMask.data[c / 64] |= uint64(1) << (c % 64);
+    }
+  }
+
+  INLINE void Lexer::DecodeLiterals(const_cstring input, ParseOffset inputLength, const ParseMatch* tokenMatches, ParseOffset nTokenMatches, NumericLiteral* literals) const
+  {
+    const_cstring const inputEnd = input + inputLength;
+    for(ParseOffset c = 0; c < nTokenMatches; ++c)
+    {
+      NumericLiteral& literal = literals[c];
+      literal.type = NumericLiteral::LITERALTYPE_NONE;
+      literal.tokenCount = 0;
+      literal.integer = 0;
+      if(tokenMatches[c].token != TOKEN_TERMINAL_LITERAL)
+        continue;
 
-      if(ParseSymbolToken(TOKENTYPE_RAW, parsePosition, remainingLength, tokenSymbolMatch))
+      const_cstring const literalBegin = input + tokenMatches[c].offset;
+      const_cstring const tokenEnd = literalBegin + tokenMatches[c].length;
+      const_cstring literalEnd = NumericLiteral::Decode(literalBegin, inputEnd, literal);
+
+      // Find the last token covered by the literal (the tokens must follow each other without any characters in between)
+      ParseOffset cLast = c;
+      while(literalEnd > input + tokenMatches[cLast].offset + tokenMatches[cLast].length && cLast + 1 < nTokenMatches
+        && tokenMatches[cLast + 1].offset == tokenMatches[cLast].offset + tokenMatches[cLast].length)
+        ++cLast;
+
+      // If the literal does not end where a token ends, decode the first token by itself
+      if(literalEnd != input + tokenMatches[cLast].offset + tokenMatches[cLast].length)
       {
-        // Parse all unparsed characters into lex word
-        if(lexWordStartPosition != parsePosition)
-        {
-          ParseMatch tokenWordMatch;
-          tokenWordMatch.offset = (uint16)(lexWordStartPosition - parseResult.inputStream.data);
-          tokenWordMatch.length = (uint8)(parsePosition - lexWordStartPosition);
+        cLast = c;
+        literalEnd = NumericLiteral::Decode(literalBegin, tokenEnd, literal);
+        if(literalEnd != tokenEnd)
+          literal.type = NumericLiteral::LITERALTYPE_INVALID; // (e.g. "12abc")
+      }
+      literal.tokenCount = (uint32)(cLast - c + 1);
 
-          // Parse word token
-          ParseWordToken(lexWordStartPosition, tokenWordMatch);
+      // The remaining tokens of the literal are not literals by themselves
+      for(; c < cLast; ++c)
+      {
+        literals[c + 1].type = NumericLiteral::LITERALTYPE_NONE;
+        literals[c + 1].tokenCount = 0;
+        literals[c + 1].integer = 0;
+      }
+    }
+  }
 
-          // Add word token to token matches
-          tokenMatches.push_back(tokenWordMatch);
-        }
+  INLINE void Lexer::DecodeLiteral(const MatchBuffer& tokenMatches, LiteralState& literalState) const
+  {
+    const ParseOffset index = tokenMatches.GetLength() - 1;
+    const ParseMatch& match = tokenMatches[index];
+    const_cstring const tokenBegin = literalState.input + match.offset;
+    const_cstring const tokenEnd = tokenBegin + match.length;
+
+    // The pending literal cannot span a token that does not follow the previous token directly or that starts beyond its end
+    if(literalState.pendingLiteralEnd != null
+      && (tokenBegin >= literalState.pendingLiteralEnd || tokenBegin != literalState.input + tokenMatches[index - 1].offset + tokenMatches[index - 1].length))
+      DecodePendingLiteral(tokenMatches, index, literalState);
+
+    literalState.literals->PushBack(NumericLiteral());
+    NumericLiteral& literal = (*literalState.literals)[index];
+    literal.type = NumericLiteral::LITERALTYPE_NONE;
+    literal.tokenCount = 0;
+    literal.integer = 0;
+    if(match.token != TOKEN_TERMINAL_LITERAL)
+      return;
 
-        // Add token to token matches
-        tokenMatches.push_back(tokenSymbolMatch);
+    const_cstring literalEnd = NumericLiteral::Decode(tokenBegin, literalState.inputEnd, literal);
 
-        // Go to next parse position
-        parsePosition += tokenSymbolMatch.length;
+    // A literal among the tokens spanned by the pending literal is decoded together with it
+    // (It may still reach beyond the pending literal if the pending literal turns out to be a single token)
+    if(literalState.pendingLiteralEnd != null)
+    {
+      literalState.pendingLiteralEnd = std::max(literalState.pendingLiteralEnd, literalEnd);
+      return;
+    }
 
-        // Reset word start position
-        lexWordStartPosition = parsePosition;
+    // A literal that reaches beyond its token may span the tokens that follow it (e.g. "1" "." "5"), which have not been lexed yet
+    if(literalEnd > tokenEnd)
+    {
+      literalState.pendingLiteral = index;
+      literalState.pendingLiteralEnd = literalEnd;
+      return;
+    }
+
+    // If the literal does not end where the token ends, decode the token by itself (see DecodeLiterals)
+    if(literalEnd != tokenEnd)
+    {
+      literalEnd = NumericLiteral::Decode(tokenBegin, tokenEnd, literal);
+      if(literalEnd != tokenEnd)
+        literal.type = NumericLiteral::LITERALTYPE_INVALID; // (e.g. "12abc")
+    }
+    literal.tokenCount = 1;
+  }
+
+  INLINE void Lexer::DecodePendingLiteral(const MatchBuffer& tokenMatches, ParseOffset nTokenMatches, LiteralState& literalState) const
+  {
+    if(literalState.pendingLiteralEnd == null)
+      return;
+
+    // (None of the literals among these tokens can span the tokens that follow them, so they are decoded exactly as in a single pass)
+    const ParseOffset pendingLiteral = literalState.pendingLiteral;
+    DecodeLiterals(literalState.input, (ParseOffset)(literalState.inputEnd - literalState.input), tokenMatches.GetData() + pendingLiteral, nTokenMatches - pendingLiteral, literalState.literals->GetData() + pendingLiteral);
+    literalState.pendingLiteralEnd = null;
+  }
+
+  INLINE void Lexer::DecodeLiteralsAround(const_cstring input, ParseOffset inputLength, const MatchBuffer& tokenMatches, NumericLiteral* literals, ParseOffset index) const
+  {
+    // A literal only spans tokens that follow each other without any characters in between
+    const ParseOffset nTokenMatches = tokenMatches.GetLength();
+    if(index == 0 || index >= nTokenMatches || tokenMatches[index].offset != tokenMatches[index - 1].offset + tokenMatches[index - 1].length)
+      return;
+
+    // Decode the whole run of adjacent tokens again
+    ParseOffset begin = index - 1;
+    while(begin > 0 && tokenMatches[begin].offset == tokenMatches[begin - 1].offset + tokenMatches[begin - 1].length)
+      --begin;
+    ParseOffset end = index + 1;
+    while(end < nTokenMatches && tokenMatches[end].offset == tokenMatches[end - 1].offset + tokenMatches[end - 1].length)
+      ++end;
+    DecodeLiterals(input, inputLength, tokenMatches.GetData() + begin, end - begin, literals + begin);
+  }
+
+  INLINE void Lexer::InternIdentifiers(const_cstring input, const ParseMatch* tokenMatches, ParseOffset nTokenMatches, SymbolTable& symbolTable, SymbolTable::SymbolId* symbols) const
+  {
+    for(ParseOffset c = 0; c < nTokenMatches; ++c)
+    {
+      const ParseMatch& match = tokenMatches[c];
+      symbols[c] = (match.token == TOKEN_TERMINAL_IDENTIFIER)? symbolTable.Intern(input + match.offset, (uint)match.length) : SymbolTable::SYMBOL_NONE;
+    }
+  }
+
+  INLINE void Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, MatchBuffer& tokenMatches) const
+  {
+    LexicalAnalysis(input, inputLength, 0, tokenMatches);
+  }
+
+  INLINE void Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches) const
+  {
+    LexicalAnalysis(input, inputLength, inputPadding, tokenMatches, null);
+  }
+
+  INLINE void Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex) const
+  {
+    LexicalAnalysis(input, inputLength, inputPadding, tokenMatches, lineIndex, null);
+  }
+
+  INLINE void Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset) const
+  {
+    LexicalAnalysis(input, inputLength, inputPadding, tokenMatches, lineIndex, invalidUtf8Offset, null);
+  }
+
+  INLINE void Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset, LiteralBuffer* literals) const
+  {
+    tokenMatches.Clear();
+    if(lineIndex != null)
+      lineIndex->Clear();
+    if(literals != null)
+      literals->Clear();
+
+    // Divide the input into chunks (one per thread)
+    const uint nChunks = (uint)std::max<ParseOffset>(1, std::min<ParseOffset>(nThreads, inputLength / MIN_THREAD_INPUT_LENGTH));
+    std::vector<ParseOffset> splits(nChunks + 1);
+    splits[0] = 0;
+    splits[nChunks] = inputLength;
+    for(uint c = 1; c < nChunks; ++c)
+      splits[c] = FindSplit(input, inputLength, std::max(splits[c - 1], (ParseOffset)(inputLength / nChunks * c)));
+
+    // Estimate the number of matches from the length of the input so that the buffer rarely needs to grow
+    // (the first chunk is lexed directly into the output buffer)
+    MatchBuffer* const threadMatches = (nChunks > 1)? new MatchBuffer[nChunks - 1] : null;
+    std::vector<MatchBuffer*> chunkMatches(nChunks);
+    LiteralBuffer* const threadLiterals = (nChunks > 1 && literals != null)? new LiteralBuffer[nChunks - 1] : null;
+    std::vector<LiteralBuffer*> chunkLiterals(nChunks, null);
+    for(uint c = 0; c < nChunks; ++c)
+    {
+      chunkMatches[c] = (c == 0)? &tokenMatches : &threadMatches[c - 1];
+      if(chunkMatches[c]->IsOwner())
+        chunkMatches[c]->Reserve((splits[c + 1] - splits[c]) / ESTIMATED_CHARACTERS_PER_MATCH + 1);
+      if(literals != null)
+      {
+        chunkLiterals[c] = (c == 0)? literals : &threadLiterals[c - 1];
+        chunkLiterals[c]->Reserve((splits[c + 1] - splits[c]) / ESTIMATED_CHARACTERS_PER_MATCH + 1);
       }
-      else if(ParseSymbolToken(TOKENTYPE_NIL, parsePosition, remainingLength, tokenSymbolMatch))
+    }
+
+    std::vector<ParseOffset> chunkEnds(nChunks);
+    if(nChunks == 1)
+    {
+      ResumeState resumeState;
+      if(invalidUtf8Offset != null)
+        *invalidUtf8Offset = inputLength;
+      chunkEnds[0] = LexicalAnalysis(input, inputLength, inputPadding, 0, inputLength, true, resumeState, tokenMatches, lineIndex, invalidUtf8Offset, literals);
+    }
+    else
+    {
+      // Lex every chunk on its own thread, assuming that a new token starts at the beginning of each chunk
+      // (Tokens that cross the end of a chunk are lexed in full)
+      // The lines of each chunk are indexed (and its literals decoded) by the thread that lexes it, as part of the same pass.
+      // (Each chunk is validated as UTF-8 on its own thread; the chunks are split after newlines, so no sequence spans two chunks)
+      std::vector<std::thread> threads;
+      std::vector<LineIndex> chunkLines((lineIndex != null)? nChunks : 0);
+      std::vector<ParseOffset> chunkInvalidUtf8Offsets(nChunks, inputLength);
+      for(uint c = 0; c < nChunks; ++c)
+        threads.push_back(std::thread([&, c]()
+        {
+          ResumeState resumeState;
+          chunkEnds[c] = splits[c] + LexicalAnalysis(input + splits[c], inputLength - splits[c], inputPadding, splits[c], splits[c + 1] - splits[c], true, resumeState, *chunkMatches[c], (lineIndex != null)? &chunkLines[c] : null, (invalidUtf8Offset != null)? &chunkInvalidUtf8Offsets[c] : null, chunkLiterals[c]);
+        }));
+      for(uint c = 0; c < nChunks; ++c)
+        threads[c].join();
+      for(uint c = 0; c < chunkLines.size(); ++c)
+        lineIndex->Append(chunkLines[c]);
+      if(invalidUtf8Offset != null)
+        *invalidUtf8Offset = *std::min_element(chunkInvalidUtf8Offsets.begin(), chunkInvalidUtf8Offsets.end());
+
+      // Verify the assumption made for each chunk: If the previous chunk ended beyond the start of the chunk,
+      // lex sequentially until the tokens coincide with those of the chunk again.
+      for(uint c = 1; c < nChunks; ++c)
       {
-        // Parse all unparsed characters into lex word
-        if(lexWordStartPosition != parsePosition)
+        const ParseOffset previousEnd = chunkEnds[c - 1];
+        if(previousEnd == splits[c])
+          continue;
+
+        MatchBuffer& matches = *chunkMatches[c];
+        MatchBuffer resynchronizedMatches;
+        LiteralBuffer resynchronizedLiterals;
+        LiteralBuffer* const sequentialLiterals = (literals != null)? &resynchronizedLiterals : null;
+        ParseOffset position = previousEnd;
+        const ParseMatch* i = matches.GetData();
+        const ParseMatch* const matchesEnd = matches.GetData() + matches.GetLength();
+        while(true)
         {
-          ParseMatch tokenWordMatch;
-          tokenWordMatch.offset = (uint16)(lexWordStartPosition - parseResult.inputStream.data);
-          tokenWordMatch.length = (uint8)(parsePosition - lexWordStartPosition);
+          // Find the next token of the chunk that could coincide with the sequential tokens
+          while(i != matchesEnd && i->offset < position)
+            ++i;
 
-          // Parse word token
-          ParseWordToken(lexWordStartPosition, tokenWordMatch);
+          // (A literal may span the tokens lexed separately on either side of the point where they are joined)
+          const ParseOffset joint = resynchronizedMatches.GetLength();
+          if(i != matchesEnd && i->offset == position)
+          {
+            resynchronizedMatches.Append(i, matchesEnd);
+            if(literals != null)
+            {
+              resynchronizedLiterals.Append(chunkLiterals[c]->GetData() + (i - matches.GetData()), chunkLiterals[c]->GetData() + chunkLiterals[c]->GetLength());
+              DecodeLiteralsAround(input, inputLength, resynchronizedMatches, resynchronizedLiterals.GetData(), joint);
+            }
+            break; // the remaining tokens of the chunk are correct
+          }
+
+          if(i == matchesEnd)
+          {
+            // Lex sequentially up to the end of the chunk
+            if(position < splits[c + 1])
+            {
+              ResumeState resumeState;
+              position += LexicalAnalysis(input + position, inputLength - position, inputPadding, position, splits[c + 1] - position, true, resumeState, resynchronizedMatches, null, null, sequentialLiterals);
+              if(literals != null)
+                DecodeLiteralsAround(input, inputLength, resynchronizedMatches, resynchronizedLiterals.GetData(), joint);
+            }
+            chunkEnds[c] = position;
+            break;
+          }
 
-          // Add word token to token matches
-          tokenMatches.push_back(tokenWordMatch);
+          // Lex sequentially up to the next token of the chunk
+          ResumeState resumeState;
+          position += LexicalAnalysis(input + position, inputLength - position, inputPadding, position, (ParseOffset)i->offset - position, true, resumeState, resynchronizedMatches, null, null, sequentialLiterals);
+          if(literals != null)
+            DecodeLiteralsAround(input, inputLength, resynchronizedMatches, resynchronizedLiterals.GetData(), joint);
         }
+        matches.Swap(resynchronizedMatches);
+        if(literals != null)
+          chunkLiterals[c]->Swap(resynchronizedLiterals);
+      }
 
-        // Ignore nil tokens... (don't add to token matches)
+      // Concatenate the matches of the remaining chunks
+      for(uint c = 1; c < nChunks; ++c)
+      {
+        const ParseOffset joint = tokenMatches.GetLength();
+        tokenMatches.Append(chunkMatches[c]->GetData(), chunkMatches[c]->GetData() + chunkMatches[c]->GetLength());
+        if(literals != null)
+        {
+          literals->Append(chunkLiterals[c]->GetData(), chunkLiterals[c]->GetData() + chunkLiterals[c]->GetLength());
+          DecodeLiteralsAround(input, inputLength, tokenMatches, literals->GetData(), joint);
+        }
+      }
+    }
 
-        // Go to next parse position
-        parsePosition += tokenSymbolMatch.length;
+    delete[] threadMatches;
+    delete[] threadLiterals;
+  }
 
-        // Reset word start position
-        lexWordStartPosition = parsePosition;
-      }
-      else if(ParseSymbolToken(TOKENTYPE_LEX, parsePosition, remainingLength, tokenSymbolMatch))
+  INLINE void Lexer::IncrementalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset editOffset, ParseOffset removedLength, ParseOffset insertedLength, MatchBuffer& tokenMatches) const
+  {
+    const ParseMatch* const previousBegin = tokenMatches.GetData();
+    const ParseMatch* const previousEnd = previousBegin + tokenMatches.GetLength();
+
+    // Find the start of the line of the edit
+    // (Single-line bounded tokens that start on an earlier line never search beyond the end of their line)
+    ParseOffset lineStart = editOffset;
+    while(lineStart > 0 && input[lineStart - 1] != '\n')
+      --lineStart;
+
+    // A multi-line bounded token that did not find its closing boundary searched up to the end of the previous input,
+    // so the whole input must be lexed again if the edit may have completed a closing boundary
+    if(EditMayCloseBoundary(input, inputLength, editOffset, insertedLength))
+      lineStart = 0;
+
+    // Find a position from which the automaton cannot read up to the line of the edit: Outside of its cycles the automaton
+    // reads at most GetMaxAcyclicLength() characters, so it stops before reading that many more characters that are not
+    // in the cycle class
+    ParseOffset restartLimit = (lineStart > 0)? lineStart - 1 : 0;
+    const CharClass& cycleClass = symbolAutomaton.GetCycleClass();
+    uint nAcyclicCharacters = 0;
+    while(restartLimit > 0 && nAcyclicCharacters <= symbolAutomaton.GetMaxAcyclicLength())
+    {
+      --restartLimit;
+      if(!cycleClass.Contains(uint8(input[restartLimit])))
+        ++nAcyclicCharacters;
+    }
+
+    // Keep the previous matches that start before the last match at or before that position, and lex again from the start
+    // of that match
+    const ParseMatch* restartMatch = std::upper_bound(previousBegin, previousEnd, restartLimit, [](ParseOffset position, const ParseMatch& match) { return position < (ParseOffset)match.offset; });
+    if(restartMatch != previousBegin)
+      --restartMatch;
+    ParseOffset position = (restartMatch != previousBegin)? (ParseOffset)restartMatch->offset : 0;
+
+    // Lex until the tokens coincide with the previous tokens that follow the edit
+    MatchBuffer relexedMatches;
+    const ParseMatch* i = std::lower_bound(restartMatch, previousEnd, editOffset + removedLength, [](const ParseMatch& match, ParseOffset offset) { return (ParseOffset)match.offset < offset; });
+    while(true)
+    {
+      // Find the next previous token that could coincide with the new tokens
+      while(i != previousEnd && (ParseOffset)i->offset - removedLength + insertedLength < position)
+        ++i;
+
+      if(i == previousEnd)
       {
-        // Parse all unparsed characters into lex word
-        if(lexWordStartPosition != parsePosition)
+        // Lex up to the end of the input
+        if(position < inputLength)
         {
-          ParseMatch tokenWordMatch;
-          tokenWordMatch.offset = (uint16)(lexWordStartPosition - parseResult.inputStream.data);
-          tokenWordMatch.length = (uint8)(parsePosition - lexWordStartPosition);
+          ResumeState resumeState;
+          LexicalAnalysis(input + position, inputLength - position, inputPadding, position, inputLength - position, true, resumeState, relexedMatches);
+        }
+        break;
+      }
 
-          // Parse word token
-          ParseWordToken(lexWordStartPosition, tokenWordMatch);
+      const ParseOffset offset = (ParseOffset)i->offset - removedLength + insertedLength;
+      if(offset == position)
+        break; // the remaining previous tokens are correct once shifted
 
-          // Add word token to token matches
-          tokenMatches.push_back(tokenWordMatch);
-        }
+      // Lex up to the next previous token
+      ResumeState resumeState;
+      position += LexicalAnalysis(input + position, inputLength - position, inputPadding, position, offset - position, true, resumeState, relexedMatches);
+    }
+
+    // Replace the matches that were lexed again and shift the remaining matches
+    const ParseOffset restartIndex = (ParseOffset)(restartMatch - previousBegin);
+    const ParseOffset nRemainingMatches = (ParseOffset)(previousEnd - i);
+    tokenMatches.Replace(restartIndex, (ParseOffset)(i - restartMatch), relexedMatches.GetData(), relexedMatches.GetData() + relexedMatches.GetLength());
+    if(insertedLength != removedLength)
+    {
+      ParseMatch* const matchesEnd = tokenMatches.GetData() + tokenMatches.GetLength();
+      for(ParseMatch* match = matchesEnd - nRemainingMatches; match != matchesEnd; ++match)
+        match->offset = match->offset - removedLength + insertedLength;
+    }
+  }
 
-        // Add token to token matches
-        tokenMatches.push_back(tokenSymbolMatch);
+  INLINE bool Lexer::EditMayCloseBoundary(const_cstring input, ParseOffset inputLength, ParseOffset editOffset, ParseOffset insertedLength) const
+  {
+    for(uint c = 0; c < symbolCandidates.size(); ++c)
+    {
+      const SymbolCandidate& candidate = symbolCandidates[c];
+      const_cstring const value = &tokenCharacters[candidate.token.valueOffset];
+      if(!candidate.bounded || value[0] != SPECIAL_MULTILINE_BOUNDING_CHAR)
+        continue;
 
-        // Go to next parse position
-        parsePosition += tokenSymbolMatch.length;
+      // Search for the closing boundary among the characters that overlap the edit
+      const_cstring const closingValue = value + 1 + strlen(value + 1) + 1;
+      const ParseOffset closingLength = (ParseOffset)strlen(closingValue);
+      if(closingLength == 0)
+        continue;
+      const_cstring const searchBegin = input + ((editOffset >= closingLength - 1)? editOffset - (closingLength - 1) : 0);
+      const_cstring const searchEnd = input + std::min(inputLength, editOffset + insertedLength + closingLength - 1);
+      if(std::search(searchBegin, searchEnd, closingValue, closingValue + closingLength) != searchEnd)
+        return true;
+    }
+    return false;
+  }
+
+  INLINE bool Lexer::ContextualAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset& position, const TerminalSet& acceptableTerminals, ParseMatch& tokenMatch) const
+  {
+    const_cstring const inputBegin     = input;
+    const_cstring const inputEnd       = &input[inputLength];
+    const_cstring parsePosition        = &input[position];
+    const_cstring lexWordStartPosition = parsePosition;
+    const bool padded = inputPadding >= Lexer::inputPadding;
 
-        // Reset word start position
+    while(parsePosition < inputEnd)
+    {
+      const uint8 character = uint8(*parsePosition);
+
+      // Skip characters on which no symbol token can start (these characters are part of a lex word)
+      if(!symbolAutomaton.CanStart(character))
+      {
+        parsePosition = CharScan::FindInClass(parsePosition + 1, inputEnd, symbolAutomaton.GetStartClass());
+        continue;
+      }
+
+      // A blank character ends the lex word before it (or is skipped along with the rest of its run)
+      if(blankClass.Contains(character))
+      {
+        if(lexWordStartPosition != parsePosition)
+          break;
+        parsePosition = CharScan::FindInClass(parsePosition + 1, inputEnd, nonBlankClass);
         lexWordStartPosition = parsePosition;
+        continue;
       }
-      else
+
+      // Match an acceptable raw token or lex symbol (or any nil token)
+      // (Any symbol token ends the lex word before it. If no acceptable token matches, the token with the highest precedence is
+      //  matched instead so that the parser can report it)
+      ParseMatch tokenSymbolMatch;
+      TokenType tokenType;
+      ResumeState resumeState;
+      const TerminalSet* const terminals = (lexWordStartPosition == parsePosition)? &acceptableTerminals : null;
+      MatchResult matchResult = padded?
+          MatchSymbol<true>(parsePosition, (ParseOffset)(inputEnd - parsePosition), true, resumeState, tokenSymbolMatch, tokenType, terminals)
+        : MatchSymbol<false>(parsePosition, (ParseOffset)(inputEnd - parsePosition), true, resumeState, tokenSymbolMatch, tokenType, terminals);
+      if(matchResult == MATCHRESULT_NONE && terminals != null)
+      {
+        matchResult = padded?
+            MatchSymbol<true>(parsePosition, (ParseOffset)(inputEnd - parsePosition), true, resumeState, tokenSymbolMatch, tokenType, null)
+          : MatchSymbol<false>(parsePosition, (ParseOffset)(inputEnd - parsePosition), true, resumeState, tokenSymbolMatch, tokenType, null);
+      }
+      if(matchResult == MATCHRESULT_NONE)
       {
         // Ignore unparsed character (current character will be evaluated as part of a lex word later)
         ++parsePosition;
+        continue;
+      }
+
+      // The lex word before the symbol is the next token
+      if(lexWordStartPosition != parsePosition)
+        break;
+
+      parsePosition += tokenSymbolMatch.length;
+      lexWordStartPosition = parsePosition;
+
+      // (Nil tokens are skipped)
+      if(tokenType != TOKENTYPE_NIL)
+      {
+        tokenMatch = tokenSymbolMatch;
+        tokenMatch.offset = (ParseOffset)(parsePosition - tokenSymbolMatch.length - inputBegin);
+        position = (ParseOffset)(parsePosition - inputBegin);
+        return true;
       }
     }
 
-    // Parse the final unparsed characters into lex word
-    if(lexWordStartPosition != parsePosition)
-    {
-      ParseMatch tokenWordMatch;
-      tokenWordMatch.offset = (uint16)(lexWordStartPosition - parseResult.inputStream.data);
-      tokenWordMatch.length = (uint8)(parsePosition - lexWordStartPosition);
+    position = (ParseOffset)(parsePosition - inputBegin);
+    if(lexWordStartPosition == parsePosition)
+      return false; // (the end of the input was reached)
 
-      // Parse word token
-      ParseWordToken(lexWordStartPosition, tokenWordMatch);
+    // Parse the unparsed characters into a lex word
+    tokenMatch.offset = (ParseOffset)(lexWordStartPosition - inputBegin);
+    tokenMatch.length = (ParseLength)(parsePosition - lexWordStartPosition);
+    ParseWordToken(lexWordStartPosition, tokenMatch, &acceptableTerminals);
+    return true;
+  }
 
-      // Add word token to token matches
-      tokenMatches.push_back(tokenWordMatch);
+  INLINE const_cstring Lexer::ValidateUtf8(const_cstring input, ParseOffset inputOffset, const_cstring validatedEnd, const_cstring validationEnd, const_cstring parsePosition, ParseOffset& invalidUtf8Offset) const
+  {
+    // Validate up to a block beyond the parse position (ending the block at the start of a sequence)
+    const_cstring const blockBegin = std::max(validatedEnd, parsePosition);
+    const_cstring const blockEnd = (validationEnd - blockBegin > ptrdiff_t(UTF8_VALIDATION_BLOCK_LENGTH))? CharScan::FindUtf8SequenceStart(validatedEnd, blockBegin + UTF8_VALIDATION_BLOCK_LENGTH) : validationEnd;
+
+    const_cstring const invalid = CharScan::FindInvalidUtf8(validatedEnd, blockEnd);
+    if(invalid != blockEnd)
+    {
+      invalidUtf8Offset = inputOffset + (ParseOffset)(invalid - input);
+      return validationEnd; // (only the first invalid sequence is reported)
     }
+    return blockEnd;
+  }
 
-    parseResult.lexStream.length = (uint)tokenMatches.size();
-    parseResult.lexStream.data = new ParseMatch[parseResult.lexStream.length];
-    memcpy(parseResult.lexStream.data, &tokenMatches[0], sizeof(ParseMatch)*parseResult.lexStream.length);
+  INLINE const_cstring Lexer::IndexLines(const_cstring input, ParseOffset inputOffset, const_cstring indexedEnd, const_cstring indexEnd, const_cstring parsePosition, LineIndex& lineIndex) const
+  {
+    // Index up to a block beyond the parse position (the offsets of the lines include inputOffset)
+    const_cstring const blockBegin = std::max(indexedEnd, parsePosition);
+    const_cstring const blockEnd = (indexEnd - blockBegin > ptrdiff_t(LINE_INDEX_BLOCK_LENGTH))? blockBegin + LINE_INDEX_BLOCK_LENGTH : indexEnd;
+    lineIndex.IndexLines(input - inputOffset, inputOffset + (ParseOffset)(indexedEnd - input), inputOffset + (ParseOffset)(blockEnd - input));
+    return blockEnd;
   }
 
-  INLINE bool Lexer::ParseSymbolToken(TokenType tokenType, const_cstring inputPosition, uint inputLength, ParseMatch& tokenMatch) const
+  INLINE ParseOffset Lexer::FindSplit(const_cstring input, ParseOffset inputLength, ParseOffset position) const
   {
-    const TokenRootIndex* const& tokenRootIndices = Lexer::tokenRootIndices[tokenType];
-    LexMatch* const&  tokens = Lexer::tokens[tokenType];
-    const char rootCharacter = *inputPosition;
+    // Split the input after a newline (where a new token is most likely to start)
+    const_cstring const newline = CharScan::FindEither(input + position, input + inputLength, '\n', '\n');
+    return (newline == input + inputLength)? inputLength : (ParseOffset)(newline - input) + 1;
+  }
 
-    // Lookup token root character
-    const TokenRootIndex& tokenRootIndex = tokenRootIndices[int(rootCharacter)];
+  INLINE ParseOffset Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches) const
+  {
+    return LexicalAnalysis(input, inputLength, inputPadding, inputOffset, splitLength, final, resumeState, tokenMatches, null);
+  }
 
-    // Parse possible characters
-    for(uint cToken = 0; cToken < tokenRootIndex.length; ++cToken)
+  INLINE ParseOffset Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches, ParseOffset* invalidUtf8Offset) const
+  {
+    return LexicalAnalysis(input, inputLength, inputPadding, inputOffset, splitLength, final, resumeState, tokenMatches, null, invalidUtf8Offset, null);
+  }
+
+  INLINE ParseOffset Lexer::LexicalAnalysis(const_cstring input, ParseOffset inputLength, ParseOffset inputPadding, ParseOffset inputOffset, ParseOffset splitLength, bool final, ResumeState& resumeState, MatchBuffer& tokenMatches, LineIndex* lineIndex, ParseOffset* invalidUtf8Offset, LiteralBuffer* literals) const
+  {
+    const_cstring const inputBegin     = input;
+    const_cstring const inputEnd       = &input[inputLength];
+    const_cstring const splitPosition  = &input[splitLength];
+    const_cstring parsePosition        = inputBegin;
+    const_cstring lexWordStartPosition = inputBegin;
+    const bool padded = final && inputPadding >= Lexer::inputPadding; // (no bounds checks are needed while matching symbols)
+
+    // The resume state only applies to the token where the previous call stopped
+    const_cstring const resumePosition = (resumeState.candidate != LexerDFA::CANDIDATE_NONE)? &inputBegin[resumeState.tokenOffset] : null;
+    ResumeState newResumeState;
+
+    // The input up to the split position is validated as UTF-8 in blocks just ahead of the parse position
+    // (so that the validator and the lexer read the same input while it is in the cache)
+    const_cstring const validationEnd = (invalidUtf8Offset != null)? std::min(splitPosition, inputEnd) : inputBegin;
+    const_cstring validatedEnd = inputBegin;
+
+    // The lines that start up to the split position are indexed in blocks just ahead of the parse position in the same way
+    const_cstring const indexEnd = (lineIndex != null)? std::min(splitPosition, inputEnd) : inputBegin;
+    const_cstring indexedEnd = inputBegin;
+
+    // Numeric literals are decoded as soon as their words are classified (the offsets of the tokens include inputOffset)
+    LiteralState literalState;
+    literalState.literals = literals;
+    literalState.input = inputBegin - inputOffset;
+    literalState.inputEnd = inputEnd;
+    literalState.pendingLiteral = 0;
+    literalState.pendingLiteralEnd = null;
+
+    while(parsePosition < inputEnd)
     {
-      const LexMatch& token = tokens[tokenRootIndex.offset + cToken];
+      if(parsePosition >= validatedEnd && validatedEnd < validationEnd)
+        validatedEnd = ValidateUtf8(inputBegin, inputOffset, validatedEnd, validationEnd, parsePosition, *invalidUtf8Offset);
+      if(parsePosition >= indexedEnd && indexedEnd < indexEnd)
+        indexedEnd = IndexLines(inputBegin, inputOffset, indexedEnd, indexEnd, parsePosition, *lineIndex);
+
+      // Stop at the first token that starts at or beyond the split position
+      if(parsePosition >= splitPosition && lexWordStartPosition == parsePosition)
+        break;
+
+      const uint8 character = uint8(*parsePosition);
 
-      if(MatchSymbolToken(token, inputPosition, inputLength, tokenMatch.length))
+      // Skip characters on which no symbol token can start (these characters are part of a lex word)
+      if(!symbolAutomaton.CanStart(character))
       {
-        tokenMatch.token = token.token;
-        return true; // token match found
+        parsePosition = CharScan::FindInClass(parsePosition + 1, inputEnd, symbolAutomaton.GetStartClass());
+        continue;
+      }
+
+      // Skip a run of blank characters (nil tokens that consist of a single character and cannot start any other token)
+      if(blankClass.Contains(character))
+      {
+        if(lexWordStartPosition != parsePosition)
+        {
+          ParseMatch tokenWordMatch;
+          tokenWordMatch.offset = inputOffset + (ParseOffset)(lexWordStartPosition - inputBegin);
+          tokenWordMatch.length = (ParseLength)(parsePosition - lexWordStartPosition);
+          ParseWordToken(lexWordStartPosition, tokenWordMatch, null);
+          tokenMatches.PushBack(tokenWordMatch);
+          if(literals != null)
+            DecodeLiteral(tokenMatches, literalState);
+        }
+
+        // (Lexing must still stop at the first token beyond the split position)
+        const_cstring const blankEnd = (splitPosition < inputEnd)? std::max(splitPosition, parsePosition + 1) : inputEnd;
+        parsePosition = CharScan::FindInClass(parsePosition + 1, blankEnd, nonBlankClass);
+        lexWordStartPosition = parsePosition;
+        continue;
       }
+
+      // Match raw token, nil token or lex symbol token (symbolic tokens that do not need to be seperated, such as operators)
+      ParseMatch tokenSymbolMatch;
+      TokenType tokenType;
+      ResumeState tokenResumeState = (parsePosition == resumePosition)? resumeState : ResumeState();
+
+      const MatchResult matchResult = padded?
+          MatchSymbol<true>(parsePosition, (ParseOffset)(inputEnd - parsePosition), final, tokenResumeState, tokenSymbolMatch, tokenType, null)
+        : MatchSymbol<false>(parsePosition, (ParseOffset)(inputEnd - parsePosition), final, tokenResumeState, tokenSymbolMatch, tokenType, null);
+      if(matchResult == MATCHRESULT_INCOMPLETE)
+      {
+        // The token at this position can only be determined once more input is available
+        // (the lex word preceding it may also still continue)
+        newResumeState = tokenResumeState;
+        newResumeState.tokenOffset = (ParseOffset)(parsePosition - lexWordStartPosition);
+        break;
+      }
+
+      if(matchResult == MATCHRESULT_NONE)
+      {
+        // Ignore unparsed character (current character will be evaluated as part of a lex word later)
+        ++parsePosition;
+        continue;
+      }
+
+      // Parse all unparsed characters into lex word
+      if(lexWordStartPosition != parsePosition)
+      {
+        ParseMatch tokenWordMatch;
+        tokenWordMatch.offset = inputOffset + (ParseOffset)(lexWordStartPosition - inputBegin);
+        tokenWordMatch.length = (ParseLength)(parsePosition - lexWordStartPosition);
+
+        // Parse word token
+        ParseWordToken(lexWordStartPosition, tokenWordMatch, null);
+
+        // Add word token to token matches
+        tokenMatches.PushBack(tokenWordMatch);
+        if(literals != null)
+          DecodeLiteral(tokenMatches, literalState);
+      }
+
+      // Add token to token matches
+      // (Ignore nil tokens... don't add them to token matches)
+      if(tokenType != TOKENTYPE_NIL)
+      {
+        tokenSymbolMatch.offset = inputOffset + (ParseOffset)(parsePosition - inputBegin);
+        tokenMatches.PushBack(tokenSymbolMatch);
+        if(literals != null)
+          DecodeLiteral(tokenMatches, literalState);
+      }
+
+      // Go to next parse position
+      parsePosition += tokenSymbolMatch.length;
+
+      // Reset word start position
+      lexWordStartPosition = parsePosition;
     }
 
-    return false; // no token match found
-  }
+    resumeState = newResumeState;
 
-  INLINE bool Lexer::MatchSymbolToken(const LexMatch& token, const_cstring inputPosition, uint inputLength, uint16& matchLength) const
-  {
-    // Precondition:
-    OSI_ASSERT(token.valueLength >= 1);
+    // Validate the rest of the input up to the split position
+    while(validatedEnd < validationEnd)
+      validatedEnd = ValidateUtf8(inputBegin, inputOffset, validatedEnd, validationEnd, validationEnd, *invalidUtf8Offset);
 
-    if(tokenCharacters[token.valueOffset] == SPECIAL_SINGLELINE_BOUNDING_CHAR || tokenCharacters[token.valueOffset] == SPECIAL_MULTILINE_BOUNDING_CHAR)
-      return MatchBoundingToken(token, inputPosition, inputLength, matchLength);
+    // Index the rest of the lines up to the split position
+    if(indexedEnd < indexEnd)
+      IndexLines(inputBegin, inputOffset, indexedEnd, indexEnd, indexEnd, *lineIndex);
 
-    uint c;
-    for(c = 0; c < (uint)(token.valueLength - 1); ++c)
+    // Parse the final unparsed characters into lex word
+    // (Unless more input may follow, in which case the word may still continue)
+    if(lexWordStartPosition != parsePosition && final)
     {
-      if(c >= inputLength)
-        return false; // no match
+      ParseMatch tokenWordMatch;
+      tokenWordMatch.offset = inputOffset + (ParseOffset)(lexWordStartPosition - inputBegin);
+      tokenWordMatch.length = (ParseLength)(parsePosition - lexWordStartPosition);
 
-      if(inputPosition[c] != tokenCharacters[token.valueOffset + c])
-        return false; // no match
+      // Parse word token
+      ParseWordToken(lexWordStartPosition, tokenWordMatch, null);
+
+      // Add word token to token matches
+      tokenMatches.PushBack(tokenWordMatch);
+      if(literals != null)
+        DecodeLiteral(tokenMatches, literalState);
+
+      lexWordStartPosition = parsePosition;
     }
 
-    matchLength = c;
-    return true;
+    // Decode the literal that is still pending at the end of the lexed tokens
+    if(literals != null)
+      DecodePendingLiteral(tokenMatches, tokenMatches.GetLength(), literalState);
+
+    return (ParseOffset)(lexWordStartPosition - inputBegin);
   }
 
-  INLINE bool Lexer::MatchBoundingToken(const LexMatch& token, const_cstring inputPosition, uint inputLength, uint16& matchLength) const
+  template<bool PADDED> INLINE Lexer::MatchResult Lexer::MatchSymbol(const_cstring inputPosition, ParseOffset inputLength, bool final, ResumeState& resumeState, ParseMatch& tokenMatch, TokenType& tokenType, const TerminalSet* acceptableTerminals) const
   {
-    //todo: refactor a little? (store lengths of boundary strings during matches)
-    const_cstring const tokenValue = &tokenCharacters[token.valueOffset];
-    const_cstring tokenValuePosition = &tokenValue[1];
-
-    // Match starting boundary
-    uint cInput = 0; // input counter
-
-    while(true)
+    const LexerDFA& automaton = symbolAutomaton;
+    LexerDFA::Candidate bestCandidate = LexerDFA::CANDIDATE_NONE; // The matching token with the highest precedence found so far
+    ParseLength bestLength = 0;                                   // The length of the best match
+    LexerDFA::State state = LexerDFA::STATE_START;
+    ParseOffset c;
+
+    // Run the automaton until no token with a higher precedence than the best match can be reached
+    // (A regular expression is matched greedily: while a longer match of the best token can be reached, the automaton continues)
+    // (Padded input needs no bounds check: No token contains a zero character, so the automaton stops at the padding)
+    for(c = 0; PADDED || c < inputLength; ++c)
     {
-      // Test whether remaining characters can contain token boundary strings
-      if((int) cInput > int(inputLength) - (token.valueLength - 3))
-        return false; // no match
+      state = automaton.Transition(state, uint8(inputPosition[c]));
+      if(state == LexerDFA::STATE_DEAD)
+        break;
 
-      // Test whether end of the first boundary string has been reached
-      if(tokenValuePosition[cInput] == '\0')
+      // Try the tokens accepted in this state that take precedence over the best match so far (or extend it)
+      // (Symbol tokens always match once accepted, but bounded tokens must still find their closing boundary)
+      for(const LexerDFA::Candidate* i = automaton.AcceptBegin(state); i != automaton.AcceptEnd(state) && *i <= bestCandidate; ++i)
       {
-        tokenValuePosition += cInput + 1; // skip closing '\0' character
-        break; // end of boundary string
-      }
+        const SymbolCandidate& candidate = symbolCandidates[*i];
+        if(acceptableTerminals != null && candidate.type != TOKENTYPE_NIL && !acceptableTerminals->Contains(candidate.token.token))
+          continue;
 
-      if(inputPosition[cInput] != tokenValuePosition[cInput])
-        return false; // no match
+        ParseLength matchLength = ParseLength(c + 1);
+        if(candidate.bounded)
+        {
+          ParseOffset searchOffset = (resumeState.candidate == *i)? resumeState.searchOffset : 0;
+          const MatchResult boundedResult = MatchBoundingToken<PADDED>(candidate, inputPosition, inputLength, final, searchOffset, matchLength);
+          if(boundedResult == MATCHRESULT_INCOMPLETE)
+          {
+            // Remember how far the closing boundary has been searched for
+            resumeState.candidate = *i;
+            resumeState.searchOffset = searchOffset;
+            return MATCHRESULT_INCOMPLETE;
+          }
+          if(boundedResult == MATCHRESULT_NONE)
+            continue;
+        }
 
-      ++cInput;
+        bestCandidate = *i;
+        bestLength = matchLength;
+        break; // (the remaining candidates in this state have a lower precedence)
+      }
+
+      const LexerDFA::Candidate bestReachableCandidate = automaton.GetBestReachableCandidate(state);
+      if(bestReachableCandidate == LexerDFA::CANDIDATE_NONE || bestReachableCandidate > bestCandidate)
+        break;
     }
 
+    // Test whether a longer token with a higher precedence could still match once more input is available
+    if(!final && c == inputLength && state != LexerDFA::STATE_DEAD && automaton.GetBestReachableCandidate(state) != LexerDFA::CANDIDATE_NONE && automaton.GetBestReachableCandidate(state) <= bestCandidate)
+      return MATCHRESULT_INCOMPLETE;
+
+    if(bestCandidate == LexerDFA::CANDIDATE_NONE)
+      return MATCHRESULT_NONE; // no token match found
+
+    const SymbolCandidate& candidate = symbolCandidates[bestCandidate];
+    tokenMatch.token = candidate.token.token;
+    tokenMatch.length = bestLength;
+    tokenType = candidate.type;
+    return MATCHRESULT_MATCH;
+  }
+
+  template<bool PADDED> INLINE Lexer::MatchResult Lexer::MatchBoundingToken(const SymbolCandidate& candidate, const_cstring inputPosition, ParseOffset inputLength, bool final, ParseOffset& searchOffset, ParseLength& matchLength) const
+  {
+    const LexMatch& token = candidate.token;
+    //todo: refactor a little? (store lengths of boundary strings during matches)
+    const_cstring const tokenValue = &tokenCharacters[token.valueOffset];
+
+    // Skip the starting boundary (already matched by the symbol automaton) and its closing '\0' character
+    const_cstring const tokenValuePosition = &tokenValue[1 + matchLength + 1];
+    ParseOffset cInput = matchLength; // input counter
+
+    const bool singleLine = (tokenCharacters[token.valueOffset] == SPECIAL_SINGLELINE_BOUNDING_CHAR);
+    const_cstring const inputEnd = inputPosition + inputLength;
+
+    // Skip the input already searched by a previous (incomplete) match
+    cInput = std::max(cInput, searchOffset);
+
     // Find end-of-line if the token type is SINGLE_LINE
     if((tokenValuePosition[0] == PARSER_TOKEN_VALUE_EOF[0] // todo: remove the EOF concept in favour of \0??
         || tokenValuePosition[0] == '\0'))
     {
-      while(cInput < inputLength)
+      if(singleLine)
+        cInput = (ParseOffset)(CharScan::FindEither(inputPosition + cInput, inputEnd, '\n', '\n') - inputPosition);
+      else // todo: perhaps make multi-line empty boundary illegal???
       {
-        if(tokenCharacters[token.valueOffset] == SPECIAL_SINGLELINE_BOUNDING_CHAR)
-        {
-          if( inputPosition[cInput] == '\n')
-            break;
-        }
-        else // todo: perhaps make multi-line empty boundary illegal???
-        {
-          OSI_ASSERT(tokenCharacters[token.valueOffset] == SPECIAL_MULTILINE_BOUNDING_CHAR);
-        }
+        OSI_ASSERT(tokenCharacters[token.valueOffset] == SPECIAL_MULTILINE_BOUNDING_CHAR);
+        cInput = inputLength;
+      }
 
-        ++cInput;
+      // The line (or input) may continue if more input is available
+      if(cInput == inputLength && !final)
+      {
+        searchOffset = cInput;
+        return MATCHRESULT_INCOMPLETE;
       }
 
-      matchLength = cInput;
-      return true;
+      matchLength = (ParseLength)cInput;
+      return MATCHRESULT_MATCH;
     }
 
     // Find ending boundary
-    bool match;
+    const uint closingLength = (uint)(token.valueLength - (tokenValuePosition - tokenValue) - 1); // length of the closing boundary string
 
-    while(true)
-    {
-      // Test whether remaining characters can contain the length of the token's closing boundary string
-      //BUG: if(cInput >= int(inputLength) - (token.valueLength - (uint)(tokenValuePosition - tokenValue)))
-      if(cInput > int(inputLength) - (token.valueLength - (uint)(tokenValuePosition - tokenValue)))
-        return false;
+    // Test whether remaining characters can contain the length of the token's closing boundary string
+    // (Padded input can be searched up to its end since the closing boundary never matches the padding)
+    if(!PADDED && cInput + closingLength > inputLength)
+      return final? MATCHRESULT_NONE : MATCHRESULT_INCOMPLETE;
 
-      // Match the token's ending boundary
-      uint cTokenValue; // token value counter (token characters)
-      match = true;
+    // Skip ahead to each possible start of the ending boundary (or to the end of the line for single-line tokens)
+    // (Note: if the \n char is part of the end boundary, the lexer will first try to match this
+    //  before returning a single-line mismatch)
+    const_cstring const searchEnd = PADDED? inputEnd : inputEnd - closingLength + 1; // (the ending boundary cannot start beyond this point)
+    const char closingCharacter = tokenValuePosition[0];
+    const char lineCharacter = singleLine? '\n' : closingCharacter;
 
-      for(cTokenValue = 0; cTokenValue < (uint)(token.valueLength - (tokenValuePosition - tokenValue) - 1); ++cTokenValue)
-      {
-        if(inputPosition[cInput + cTokenValue] != tokenValuePosition[cTokenValue])
-        {
-          match = false;
-          break;
-        }
-      }
+    for(const_cstring position = inputPosition + cInput; position < searchEnd; ++position)
+    {
+      position = CharScan::FindEither(position, searchEnd, closingCharacter, lineCharacter);
+      if(position == searchEnd)
+        break;
 
-      if(match)
+      // Match the token's ending boundary
+      if(PADDED? MatchPaddedBoundary(candidate, position, tokenValuePosition, closingLength) : memcmp(position, tokenValuePosition, closingLength) == 0)
       {
-        matchLength = cInput + cTokenValue;
-        return true;
+        matchLength = (ParseLength)(position - inputPosition) + closingLength;
+        return MATCHRESULT_MATCH;
       }
 
       // Test for end-of-line and return an error if the bounding token is a single-line type
-      // (Note: if the \n char is part of the end boundary, the lexer will first try to match this
-      //  before returning a single-line mismatch here)
-      // todo: test
-      if(inputPosition[cInput] == '\n'
-          && tokenCharacters[token.valueOffset] == SPECIAL_SINGLELINE_BOUNDING_CHAR)
-        return false; // error: single-line mismatch (no ending boundary string found for boundary token)
-
-      ++cInput;
+      if(singleLine && *position == '\n')
+        return MATCHRESULT_NONE; // error: single-line mismatch (no ending boundary string found for boundary token)
     }
 
-    return false;
+    // The ending boundary may still follow if more input is available
+    if(!final)
+    {
+      searchOffset = (ParseOffset)(searchEnd - inputPosition);
+      return MATCHRESULT_INCOMPLETE;
+    }
+    return MATCHRESULT_NONE;
+  }
+
+  FORCE_INLINE bool Lexer::MatchPaddedBoundary(const SymbolCandidate& candidate, const_cstring inputPosition, const_cstring boundary, uint boundaryLength)
+  {
+    // Compare the first 8 characters under a mask (reading past the end of the input into the padding)
+    uint64 inputCharacters;
+    memcpy(&inputCharacters, inputPosition, 8);
+    if(((inputCharacters ^ candidate.closingPrefix) & candidate.closingMask) != 0)
+      return false;
+
+    // Compare the remaining characters (of long closing boundaries)
+    return boundaryLength <= 8 || memcmp(inputPosition + 8, boundary + 8, boundaryLength - 8) == 0;
   }
 
-  INLINE void Lexer::ParseWordToken(const_cstring inputPosition, ParseMatch& tokenMatch) const
+  INLINE void Lexer::ParseWordToken(const_cstring inputPosition, ParseMatch& tokenMatch, const TerminalSet* acceptableTerminals) const
   {
     const TokenRootIndex* const& tokenRootIndices = lexWordTokenRootIndices;
     LexMatch* const& tokens = lexWordTokens;
     const char rootCharacter = *inputPosition;
 
-    // Lookup token root character
-    const TokenRootIndex& tokenRootIndex = tokenRootIndices[int(rootCharacter)];
-
-    // Parse possible characters
-    for(uint cToken = 0; cToken < tokenRootIndex.length; ++cToken)
+    // Look up the word in the keyword hash
+    if(!keywordHash.IsEmpty())
     {
-      const LexMatch& token = tokens[tokenRootIndex.offset + cToken];
-
-      // Use input length to quickly discard token words
-      if(token.valueLength - 1 != tokenMatch.length)
-        continue;
-
-      // Match token
-      if(MatchWordToken(token, inputPosition))
+      const KeywordHash::Index index = keywordHash.Find(inputPosition, tokenMatch.length);
+      if(index != KeywordHash::INDEX_NONE && (acceptableTerminals == null || acceptableTerminals->Contains(tokens[index].token)))
       {
-        tokenMatch.token = token.token;
+        tokenMatch.token = tokens[index].token;
         return; // token match found
       }
     }
+    else
+    {
+      // Lookup token root character
+      const TokenRootIndex& tokenRootIndex = tokenRootIndices[uint8(rootCharacter)];
+
+      // Parse possible characters
+      for(uint cToken = 0; cToken < tokenRootIndex.length; ++cToken)
+      {
+        const LexMatch& token = tokens[tokenRootIndex.offset + cToken];
+
+        // Use input length to quickly discard token words
+        if(token.valueLength - 1 != tokenMatch.length)
+          continue;
+
+        // Match token
+        if(MatchWordToken(token, inputPosition))
+        {
+          if(acceptableTerminals != null && !acceptableTerminals->Contains(token.token))
+            break; // (lex words that are not acceptable are identifiers)
+
+          tokenMatch.token = token.token;
+          return; // token match found
+        }
+      }
+    }
 
     // Test whether word is a numeric constant or an identifier
     // Notes: Negative numerals are separated from their unary - operator, so no need to parse for '-' characters.
@@ -0,0 +1,151 @@
+#ifndef __QPARSER_LEXERDFA_H__
+#define __QPARSER_LEXERDFA_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LEXERDFA.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A deterministic automaton used by the lexer to recognize all symbol
+      tokens (raw, nil, lex symbols and the opening boundaries of bounded
+      tokens) in a single pass over the input.
+
+    IMPLEMENTATION:
+      + Every token is identified by a "candidate" number. Candidates are
+        numbered in order of precedence so that a lower candidate always
+        wins when more than one token matches the input.
+      + The input alphabet is compressed into byte classes (bytes that
+        behave identically in every state share a class) so that the
+        transition table stays small.
+      + A separate character class holds the characters on which any string
+        can start, so that the lexer can skip over runs of word characters
+        without running the automaton.
+      + Strings are added along a tree of transitions from the start state
+        and regular expressions are added by Thompson's construction (joined
+        to the start state by empty transitions). Build converts this
+        nondeterministic automaton into a deterministic one by the subset
+        construction and then minimizes it (by partition refinement), so
+        strings and regular expressions share a single transition table.
+      + State 0 is the dead state (no token can match any longer) and
+        state 1 is the start state. The remaining states are numbered in the
+        order in which they are reached from the start state.
+      + The characters read on transitions within cycles of the automaton
+        and the largest number of other characters read before the automaton
+        stops are kept, to bound how far ahead of a match the automaton can
+        read (see Lexer::IncrementalAnalysis).
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class LexerDFA
+  {
+  public:
+    // Automaton states
+    typedef uint32 State;
+    static const State STATE_DEAD  = 0; // The state reached once no token can match the input
+    static const State STATE_START = 1; // The state in which every match begins
+
+    // Accepting candidates (lower values take precedence)
+    typedef uint32 Candidate;
+    static const Candidate CANDIDATE_NONE = ~Candidate(0);
+
+    // Construction
+    INLINE LexerDFA();
+
+    // Remove all strings from the automaton
+    INLINE void Clear();
+
+    // Add a string that accepts the given candidate once all of its characters have been matched
+    INLINE void AddString(const_cstring value, uint length, Candidate candidate);
+
+    // Add a regular expression that accepts the given candidate once all the characters of a match have been read
+    INLINE void AddRegex(const Regex& regex, Candidate candidate);
+
+    // Convert the automaton into a minimal deterministic automaton, compress the alphabet into byte classes and pack the
+    // transition table so that it can be used for matching
+    INLINE void Build();
+
+    //// Accessors
+    // Follow the transition from a state on an input character
+    FORCE_INLINE State Transition(State state, uint8 character) const { return transitions[state * nClasses + byteClasses[character]]; }
+
+    // Test whether any string starts with the input character (bytes for which this is false can be skipped without running the automaton)
+    FORCE_INLINE bool CanStart(uint8 character) const { return startClass.Contains(character); }
+
+    // Get the class of all characters on which any string can start
+    FORCE_INLINE const CharClass& GetStartClass() const { return startClass; }
+
+    // Get the candidates accepted in a state (sorted in order of precedence)
+    FORCE_INLINE const Candidate* AcceptBegin(State state) const { return &acceptCandidates[0] + acceptOffsets[state]; }
+    FORCE_INLINE const Candidate* AcceptEnd(State state) const { return &acceptCandidates[0] + acceptOffsets[state + 1]; }
+
+    // Get the best candidate accepted by any state that can still be reached from the given state
+    FORCE_INLINE Candidate GetBestReachableCandidate(State state) const { return bestReachableCandidates[state]; }
+
+    // Get the class of all characters read on transitions within cycles of the automaton
+    FORCE_INLINE const CharClass& GetCycleClass() const { return cycleClass; }
+
+    // Get the largest number of characters outside of the cycle class that the automaton reads from the start state
+    // (including the character on which it stops)
+    INLINE uint GetMaxAcyclicLength() const { return maxAcyclicLength; }
+
+    // Get the number of states and byte classes in the automaton
+    INLINE uint GetStateCount() const { return (uint)bestReachableCandidates.size(); }
+    INLINE uint GetClassCount() const { return nClasses; }
+
+  protected:
+    // A state of the nondeterministic automaton used during construction
+    struct ConstructionState
+    {
+      std::map<uint8, State> edges;     // Outgoing transitions by input character
+      std::vector<State> epsilons;      // Outgoing transitions that read no input
+      std::vector<Candidate> accepts;   // Candidates accepted in this state
+    };
+    typedef std::vector<ConstructionState> ConstructionStates;
+
+    ConstructionStates constructionStates;        // States used during construction (discarded by Build)
+
+    uint16 byteClasses[256];                      // The byte class of every input character
+    uint nClasses;                                // Number of byte classes
+    CharClass startClass;                         // The input characters that leave the start state
+    std::vector<State> transitions;               // Transition table (indexed by state * nClasses + byte class)
+    std::vector<uint32> acceptOffsets;            // Offset of each state's accepted candidates (with one extra entry marking the end)
+    std::vector<Candidate> acceptCandidates;      // Concatenation of all accepted candidates
+    std::vector<Candidate> bestReachableCandidates; // The best candidate reachable from each state
+    CharClass cycleClass;                         // The characters read on transitions within cycles
+    uint maxAcyclicLength;                        // The largest number of characters outside of cycleClass read from the start state
+
+    // Add the states and transitions that match a node of a regular expression between two states (Thompson's construction)
+    INLINE void AddRegexNode(const Regex& regex, uint node, State begin, State end);
+
+    // Add a state to the nondeterministic automaton
+    INLINE State AddConstructionState();
+
+    // Convert the nondeterministic automaton into a deterministic automaton (the subset construction) with a transition for
+    // every input character
+    INLINE void BuildSubsets(std::vector<State>& subsetTransitions, std::vector< std::vector<Candidate> >& subsetAccepts) const;
+
+    // Merge the equivalent states of a deterministic automaton (whose transitions are given per byte class) and number the
+    // remaining states in the order in which they are reached
+    INLINE void Minimize(const std::vector<State>& classTransitions, const std::vector< std::vector<Candidate> >& accepts, std::vector<State>& minimalTransitions, std::vector< std::vector<Candidate> >& minimalAccepts) const;
+
+    // Group the columns of a transition table that are equal in every state (returns the number of groups)
+    static INLINE uint GroupColumns(const std::vector<State>& table, uint nColumns, std::vector<uint16>& columnGroups);
+
+    // Compute the best candidate reachable from every state
+    INLINE void BuildReachableCandidates();
+
+    // Compute the cycle class and the largest acyclic length
+    INLINE void BuildCycles();
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "lexerdfa.inl"
+
+#endif
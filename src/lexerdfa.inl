@@ -0,0 +1,484 @@
+#ifdef  __QPARSER_LEXERDFA_H__
+#ifndef __QPARSER_LEXERDFA_INL__
+#define __QPARSER_LEXERDFA_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LEXERDFA.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  const LexerDFA::State LexerDFA::STATE_DEAD;
+  const LexerDFA::State LexerDFA::STATE_START;
+  const LexerDFA::Candidate LexerDFA::CANDIDATE_NONE;
+
+  INLINE LexerDFA::LexerDFA()
+  {
+    // Start out with an empty automaton (which never accepts any input)
+    Clear();
+    Build();
+  }
+
+  INLINE void LexerDFA::Clear()
+  {
+    constructionStates.clear();
+    constructionStates.resize(STATE_START + 1); // (the dead state and the start state)
+  }
+
+  INLINE void LexerDFA::AddString(const_cstring value, uint length, Candidate candidate)
+  {
+    // Follow (or create) the path of transitions for the string, starting from the start state
+    State state = STATE_START;
+    for(uint c = 0; c < length; ++c)
+    {
+      const uint8 character = uint8(value[c]);
+      auto i = constructionStates[state].edges.find(character);
+      if(i == constructionStates[state].edges.end())
+      {
+        // (note: push_back may invalidate references into the construction states)
+        const State newState = State(constructionStates.size());
+        constructionStates.push_back(ConstructionState());
+        constructionStates[state].edges[character] = newState;
+        state = newState;
+      }
+      else
+        state = i->second;
+    }
+
+    // Accept the candidate in the final state
+    constructionStates[state].accepts.push_back(candidate);
+  }
+
+  INLINE void LexerDFA::AddRegex(const Regex& regex, Candidate candidate)
+  {
+    // Join the expression to the start state and accept the candidate in its final state
+    const State begin = AddConstructionState();
+    const State end = AddConstructionState();
+    constructionStates[STATE_START].epsilons.push_back(begin);
+    AddRegexNode(regex, regex.GetRoot(), begin, end);
+    constructionStates[end].accepts.push_back(candidate);
+  }
+
+  INLINE void LexerDFA::AddRegexNode(const Regex& regex, uint node, State begin, State end)
+  {
+    // (Every node only adds transitions that leave begin or enter end, apart from transitions between new states)
+    const Regex::Node& regexNode = regex.GetNode(node);
+    switch(regexNode.type)
+    {
+    case Regex::NODETYPE_CHARACTERS:
+      {
+        const State state = AddConstructionState();
+        constructionStates[begin].epsilons.push_back(state);
+        for(uint c = 0; c <= MAX_UINT8; ++c)
+          if(regexNode.characters.Contains(uint8(c)))
+            constructionStates[state].edges[uint8(c)] = end;
+        break;
+      }
+
+    case Regex::NODETYPE_CONCATENATION:
+      {
+        const State middle = AddConstructionState();
+        AddRegexNode(regex, regexNode.left, begin, middle);
+        AddRegexNode(regex, regexNode.right, middle, end);
+        break;
+      }
+
+    case Regex::NODETYPE_ALTERNATION:
+      AddRegexNode(regex, regexNode.left, begin, end);
+      AddRegexNode(regex, regexNode.right, begin, end);
+      break;
+
+    case Regex::NODETYPE_REPETITION:
+      {
+        // Match the required repetitions one after the other
+        State state = begin;
+        for(uint c = 0; c < regexNode.minCount; ++c)
+        {
+          const State next = AddConstructionState();
+          AddRegexNode(regex, regexNode.left, state, next);
+          state = next;
+        }
+
+        if(regexNode.maxCount == Regex::REPETITION_UNBOUNDED)
+        {
+          // Loop through a new state for any further repetitions
+          const State loop = AddConstructionState();
+          constructionStates[state].epsilons.push_back(loop);
+          AddRegexNode(regex, regexNode.left, loop, loop);
+          constructionStates[loop].epsilons.push_back(end);
+        }
+        else
+        {
+          // Each optional repetition may be skipped
+          for(uint c = regexNode.minCount; c < regexNode.maxCount; ++c)
+          {
+            const State next = AddConstructionState();
+            constructionStates[state].epsilons.push_back(end);
+            AddRegexNode(regex, regexNode.left, state, next);
+            state = next;
+          }
+          constructionStates[state].epsilons.push_back(end);
+        }
+        break;
+      }
+    }
+  }
+
+  INLINE LexerDFA::State LexerDFA::AddConstructionState()
+  {
+    constructionStates.push_back(ConstructionState());
+    return State(constructionStates.size() - 1);
+  }
+
+  INLINE void LexerDFA::Build()
+  {
+    // Convert the construction states into a deterministic automaton
+    std::vector<State> subsetTransitions;
+    std::vector< std::vector<Candidate> > subsetAccepts;
+    BuildSubsets(subsetTransitions, subsetAccepts);
+    const uint nSubsets = (uint)subsetAccepts.size();
+
+    // Compress the alphabet: Characters that lead to the same transitions in every state share a byte class
+    std::vector<uint16> characterClasses;
+    const uint nCharacterClasses = GroupColumns(subsetTransitions, 256, characterClasses);
+    std::vector<State> classTransitions(nSubsets * nCharacterClasses);
+    for(uint state = 0; state < nSubsets; ++state)
+      for(uint c = 0; c < 256; ++c)
+        classTransitions[state * nCharacterClasses + characterClasses[c]] = subsetTransitions[state * 256 + c];
+    std::vector<State>().swap(subsetTransitions);
+
+    // Merge equivalent states
+    std::vector< std::vector<Candidate> > accepts;
+    Minimize(classTransitions, subsetAccepts, transitions, accepts);
+    const uint nStates = (uint)accepts.size();
+
+    // Merging states may make more characters equivalent, so the byte classes are compressed once more
+    {
+      std::vector<uint16> classGroups;
+      nClasses = GroupColumns(transitions, nCharacterClasses, classGroups);
+      std::vector<State> groupTransitions(nStates * nClasses);
+      for(uint state = 0; state < nStates; ++state)
+        for(uint c = 0; c < nCharacterClasses; ++c)
+          groupTransitions[state * nClasses + classGroups[c]] = transitions[state * nCharacterClasses + c];
+      transitions.swap(groupTransitions);
+      for(uint c = 0; c < 256; ++c)
+        byteClasses[c] = classGroups[characterClasses[c]];
+    }
+
+    // Collect the characters on which the start state has a transition
+    startClass.Clear();
+    for(uint c = 0; c < 256; ++c)
+      if(transitions[STATE_START * nClasses + byteClasses[c]] != STATE_DEAD)
+        startClass.Add(uint8(c));
+
+    // Pack the accepted candidates of each state in order of precedence
+    acceptOffsets.resize(nStates + 1);
+    acceptCandidates.clear();
+    for(State state = 0; state < nStates; ++state)
+    {
+      acceptOffsets[state] = (uint32)acceptCandidates.size();
+      acceptCandidates.insert(acceptCandidates.end(), accepts[state].begin(), accepts[state].end());
+    }
+    acceptOffsets[nStates] = (uint32)acceptCandidates.size();
+    acceptCandidates.push_back(CANDIDATE_NONE); // (sentinel so that AcceptBegin is always valid)
+
+    BuildReachableCandidates();
+    BuildCycles();
+
+    // The construction states are no longer needed
+    ConstructionStates().swap(constructionStates);
+  }
+
+  INLINE void LexerDFA::BuildSubsets(std::vector<State>& subsetTransitions, std::vector< std::vector<Candidate> >& subsetAccepts) const
+  {
+    typedef std::vector<State> Subset;
+    std::map<Subset, State> subsetStates;
+    std::vector<Subset> subsets;
+
+    // Marks used to find the closure of a subset (a state belongs to the closure being built if its mark equals closureMark)
+    std::vector<uint32> marks(constructionStates.size(), 0);
+    uint32 closureMark = 0;
+    std::vector<State> stack;
+
+    // Complete a subset with all states reachable through empty transitions (and sort it), then find or add its state
+    auto findSubsetState = [&](Subset& subset) -> State
+    {
+      ++closureMark;
+      stack.assign(subset.begin(), subset.end());
+      subset.clear();
+      while(!stack.empty())
+      {
+        const State state = stack.back();
+        stack.pop_back();
+        if(marks[state] == closureMark)
+          continue;
+        marks[state] = closureMark;
+        subset.push_back(state);
+        stack.insert(stack.end(), constructionStates[state].epsilons.begin(), constructionStates[state].epsilons.end());
+      }
+      std::sort(subset.begin(), subset.end());
+
+      auto i = subsetStates.find(subset);
+      if(i != subsetStates.end())
+        return i->second;
+      const State subsetState = State(subsets.size());
+      subsetStates.insert(std::make_pair(subset, subsetState));
+      subsets.push_back(subset);
+      return subsetState;
+    };
+
+    // The empty subset is the dead state and the closure of the start state is the start state
+    Subset subset;
+    findSubsetState(subset);
+    subset.assign(1, STATE_START);
+    findSubsetState(subset);
+
+    // Follow the transitions of every subset on every input character
+    std::vector<Subset> targets(256);
+    subsetTransitions.clear();
+    subsetAccepts.clear();
+    for(State subsetState = 0; subsetState < subsets.size(); ++subsetState)
+    {
+      const Subset members = subsets[subsetState]; // (subsets may grow while the transitions are added)
+      std::vector<Candidate> accepts;
+      for(uint c = 0; c < members.size(); ++c)
+      {
+        const ConstructionState& state = constructionStates[members[c]];
+        for(auto i = state.edges.begin(); i != state.edges.end(); ++i)
+          targets[i->first].push_back(i->second);
+        accepts.insert(accepts.end(), state.accepts.begin(), state.accepts.end());
+      }
+
+      std::sort(accepts.begin(), accepts.end());
+      accepts.erase(std::unique(accepts.begin(), accepts.end()), accepts.end());
+      subsetAccepts.push_back(accepts);
+
+      subsetTransitions.resize(subsetTransitions.size() + 256, STATE_DEAD);
+      for(uint c = 0; c < 256; ++c)
+      {
+        if(targets[c].empty())
+          continue;
+        subsetTransitions[subsetState * 256 + c] = findSubsetState(targets[c]);
+        targets[c].clear();
+      }
+    }
+  }
+
+  INLINE void LexerDFA::Minimize(const std::vector<State>& classTransitions, const std::vector< std::vector<Candidate> >& accepts, std::vector<State>& minimalTransitions, std::vector< std::vector<Candidate> >& minimalAccepts) const
+  {
+    const uint nStates = (uint)accepts.size();
+    const uint nColumns = (uint)(classTransitions.size() / nStates);
+
+    // Start out with one block for each distinct set of accepted candidates
+    std::vector<uint32> blocks(nStates);
+    uint nBlocks;
+    {
+      std::map<std::vector<Candidate>, uint32> acceptBlocks;
+      for(State state = 0; state < nStates; ++state)
+        blocks[state] = acceptBlocks.insert(std::make_pair(accepts[state], uint32(acceptBlocks.size()))).first->second;
+      nBlocks = (uint)acceptBlocks.size();
+    }
+
+    // Split the blocks by the blocks of their transitions until no block can be split any further
+    while(true)
+    {
+      std::map<std::vector<uint32>, uint32> signatureBlocks;
+      std::vector<uint32> newBlocks(nStates);
+      std::vector<uint32> signature(nColumns + 1);
+      for(State state = 0; state < nStates; ++state)
+      {
+        signature[0] = blocks[state];
+        for(uint c = 0; c < nColumns; ++c)
+          signature[c + 1] = blocks[classTransitions[state * nColumns + c]];
+        newBlocks[state] = signatureBlocks.insert(std::make_pair(signature, uint32(signatureBlocks.size()))).first->second;
+      }
+      blocks.swap(newBlocks);
+      if(signatureBlocks.size() == nBlocks)
+        break;
+      nBlocks = (uint)signatureBlocks.size();
+    }
+
+    // Number the blocks in the order in which they are reached from the start state (the dead state keeps state 0)
+    // (If the start state is equivalent to the dead state, it is kept as a separate state)
+    const uint32 BLOCK_NONE = ~uint32(0);
+    std::vector<State> representatives(nBlocks, STATE_DEAD);
+    for(State state = nStates; state-- > 0;)
+      representatives[blocks[state]] = state;
+    std::vector<State> blockStates(nBlocks, BLOCK_NONE);
+    std::vector<uint32> order;
+    blockStates[blocks[STATE_DEAD]] = STATE_DEAD;
+    order.push_back(blocks[STATE_DEAD]);
+    if(blocks[STATE_START] != blocks[STATE_DEAD])
+    {
+      blockStates[blocks[STATE_START]] = STATE_START;
+      order.push_back(blocks[STATE_START]);
+    }
+    else
+      order.push_back(blocks[STATE_DEAD]);
+
+    for(uint c = 1; c < order.size(); ++c)
+    {
+      const State representative = representatives[order[c]];
+      for(uint column = 0; column < nColumns; ++column)
+      {
+        const uint32 block = blocks[classTransitions[representative * nColumns + column]];
+        if(blockStates[block] == BLOCK_NONE)
+        {
+          blockStates[block] = State(order.size());
+          order.push_back(block);
+        }
+      }
+    }
+
+    // Build the transitions of the merged states
+    const uint nMinimalStates = (uint)order.size();
+    minimalTransitions.assign(nMinimalStates * nColumns, STATE_DEAD);
+    minimalAccepts.resize(nMinimalStates);
+    for(State state = 0; state < nMinimalStates; ++state)
+    {
+      const State representative = (state == STATE_START)? STATE_START : representatives[order[state]];
+      minimalAccepts[state] = accepts[representative];
+      if(state == STATE_DEAD)
+        continue;
+      for(uint column = 0; column < nColumns; ++column)
+        minimalTransitions[state * nColumns + column] = blockStates[blocks[classTransitions[representative * nColumns + column]]];
+    }
+  }
+
+  INLINE uint LexerDFA::GroupColumns(const std::vector<State>& table, uint nColumns, std::vector<uint16>& columnGroups)
+  {
+    // (All columns that only lead to the dead state end up in group 0)
+    const uint nRows = (uint)(table.size() / nColumns);
+    typedef std::vector<State> Column;
+    std::map<Column, uint16> groups;
+    groups[Column(nRows, STATE_DEAD)] = 0;
+    columnGroups.resize(nColumns);
+    Column column(nRows);
+    for(uint c = 0; c < nColumns; ++c)
+    {
+      for(uint row = 0; row < nRows; ++row)
+        column[row] = table[row * nColumns + c];
+      columnGroups[c] = groups.insert(std::make_pair(column, uint16(groups.size()))).first->second;
+    }
+    return (uint)groups.size();
+  }
+
+  INLINE void LexerDFA::BuildReachableCandidates()
+  {
+    const uint nStates = (uint)acceptOffsets.size() - 1;
+    bestReachableCandidates.assign(nStates, CANDIDATE_NONE);
+
+    // Propagate the best accepted candidates backwards along the transitions until nothing changes
+    // (States are created in the order that they are reached, so a single backwards sweep usually suffices)
+    bool changed;
+    do
+    {
+      changed = false;
+      for(State state = nStates; state-- > STATE_START;)
+      {
+        Candidate best = bestReachableCandidates[state];
+        for(uint c = 0; c < nClasses; ++c)
+        {
+          const State target = transitions[state * nClasses + c];
+          if(target == STATE_DEAD)
+            continue;
+          if(acceptOffsets[target] != acceptOffsets[target + 1])
+            best = std::min(best, acceptCandidates[acceptOffsets[target]]);
+          best = std::min(best, bestReachableCandidates[target]);
+        }
+
+        if(best != bestReachableCandidates[state])
+        {
+          bestReachableCandidates[state] = best;
+          changed = true;
+        }
+      }
+    } while(changed);
+  }
+
+  INLINE void LexerDFA::BuildCycles()
+  {
+    const uint nStates = (uint)bestReachableCandidates.size();
+    const uint32 INDEX_NONE = ~uint32(0);
+
+    // Find the strongly connected components of the automaton (Tarjan's algorithm, without recursion)
+    // Components are completed in reverse topological order, i.e. after all the components reachable from them.
+    std::vector<uint32> indices(nStates, INDEX_NONE), lowLinks(nStates, 0), components(nStates, INDEX_NONE);
+    std::vector<State> componentStack;
+    std::vector< std::pair<State, uint> > callStack; // (state, next byte class to visit)
+    std::vector<uint> componentLengths;               // The largest acyclic length from each component
+    uint32 nextIndex = 0;
+
+    cycleClass.Clear();
+    for(State root = STATE_START; root < nStates; ++root)
+    {
+      if(indices[root] != INDEX_NONE)
+        continue;
+
+      callStack.push_back(std::make_pair(root, 0u));
+      indices[root] = lowLinks[root] = nextIndex++;
+      componentStack.push_back(root);
+      while(!callStack.empty())
+      {
+        const State state = callStack.back().first;
+        uint& c = callStack.back().second;
+        if(c < nClasses)
+        {
+          const State target = transitions[state * nClasses + c++];
+          if(target == STATE_DEAD)
+            continue;
+          if(indices[target] == INDEX_NONE)
+          {
+            indices[target] = lowLinks[target] = nextIndex++;
+            componentStack.push_back(target);
+            callStack.push_back(std::make_pair(target, 0u));
+          }
+          else if(components[target] == INDEX_NONE)
+            lowLinks[state] = std::min(lowLinks[state], indices[target]);
+          continue;
+        }
+
+        callStack.pop_back();
+        if(!callStack.empty())
+          lowLinks[callStack.back().first] = std::min(lowLinks[callStack.back().first], lowLinks[state]);
+        if(lowLinks[state] != indices[state])
+          continue;
+
+        // Complete the component rooted at this state
+        const uint32 component = (uint32)componentLengths.size();
+        const std::vector<State>::iterator componentBegin = std::find(componentStack.begin(), componentStack.end(), state);
+        for(std::vector<State>::iterator i = componentBegin; i != componentStack.end(); ++i)
+          components[*i] = component;
+
+        // Collect the characters read within the component and the largest acyclic length through the components that follow it
+        // (Every character outside of the cycle class leaves a component, either to a later component or to the dead state)
+        uint length = 0;
+        for(std::vector<State>::iterator i = componentBegin; i != componentStack.end(); ++i)
+          for(uint cClass = 0; cClass < nClasses; ++cClass)
+          {
+            const State target = transitions[*i * nClasses + cClass];
+            if(target == STATE_DEAD)
+              continue;
+            if(components[target] == component)
+            {
+              for(uint character = 0; character <= MAX_UINT8; ++character)
+                if(byteClasses[character] == cClass)
+                  cycleClass.Add(uint8(character));
+            }
+            else
+              length = std::max(length, componentLengths[components[target]]);
+          }
+        componentLengths.push_back(length + 1);
+        componentStack.erase(componentBegin, componentStack.end());
+      }
+    }
+
+    maxAcyclicLength = (nStates > STATE_START)? componentLengths[components[STATE_START]] : 1;
+  }
+}
+
+#endif
+#endif
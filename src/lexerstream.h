@@ -0,0 +1,74 @@
+#ifndef __QPARSER_LEXERSTREAM_H__
+#define __QPARSER_LEXERSTREAM_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LEXERSTREAM.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      Streaming interface to the lexer. Input is fed to the stream in chunks
+      and lexical tokens are produced as soon as they can be determined, so
+      that the whole input never needs to be held in memory.
+
+    IMPLEMENTATION:
+      + Only the characters of the token(s) that could not be determined
+        yet are kept between chunks: a pending lex word, a partially
+        matched symbol or a bounded token whose closing boundary has not
+        been found yet. (The search for the closing boundary resumes where
+        it left off instead of starting over)
+      + While a multi-line bounded token is open, only its opening boundary
+        and the last few characters that may still start its closing
+        boundary are kept (see Lexer::GetTrimmableToken), so a stray
+        opening boundary does not buffer the rest of the stream. The
+        discarded characters are added back to the offsets and lengths of
+        the matches once the token closes. (If the stream ends before it
+        closes, the token is matched up to the end of the stream since its
+        characters can not be lexed again)
+      + The offsets of the produced matches are relative to the start of
+        the stream.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class LexerStream
+  {
+  public:
+    typedef MatchBuffer Matches;
+
+    // Construction
+    INLINE LexerStream(const Lexer& lexer);
+
+    // Lex the next chunk of input, appending all lexical tokens that can be determined so far to the matches
+    INLINE void Feed(const_cstring chunk, ParseOffset chunkLength, Matches& matches);
+
+    // Signal the end of the input, appending the remaining lexical tokens to the matches
+    INLINE void Finish(Matches& matches);
+
+    // Discard all pending input and start a new stream
+    INLINE void Reset();
+
+    //// Accessors
+    // Get the offset of the first character that has not been consumed yet
+    INLINE ParseOffset GetOffset() const { return pendingOffset; }
+
+    // Get the number of characters held back until more input is available
+    INLINE ParseOffset GetPendingLength() const { return (ParseOffset)pending.size(); }
+
+  protected:
+    const Lexer& lexer;               // The lexer definition used to lex the stream
+    std::vector<char> pending;        // Characters that have not been consumed yet
+    ParseOffset pendingOffset;        // Offset of the first pending character in the stream
+    Lexer::ResumeState resumeState;   // The progress of the token at the pending characters
+    ParseOffset discardedLength;      // Number of characters of the open bounded token discarded after its opening boundary
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "lexerstream.inl"
+
+#endif
@@ -0,0 +1,111 @@
+#ifdef  __QPARSER_LEXERSTREAM_H__
+#ifndef __QPARSER_LEXERSTREAM_INL__
+#define __QPARSER_LEXERSTREAM_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LEXERSTREAM.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  INLINE LexerStream::LexerStream(const Lexer& lexer) : lexer(lexer), pendingOffset(0), discardedLength(0) {}
+
+  INLINE void LexerStream::Feed(const_cstring chunk, ParseOffset chunkLength, Matches& matches)
+  {
+    // Lex the chunk directly if no characters are pending (otherwise append it to the pending characters)
+    const_cstring input = chunk;
+    ParseOffset inputLength = chunkLength;
+    if(!pending.empty())
+    {
+      pending.insert(pending.end(), chunk, chunk + chunkLength);
+      input = &pending[0];
+      inputLength = (ParseOffset)pending.size();
+    }
+
+    const ParseOffset tokenOffset = resumeState.tokenOffset;
+    const ParseOffset firstMatch = matches.GetLength();
+    const ParseOffset consumed = lexer.LexicalAnalysis(input, inputLength, 0, pendingOffset, inputLength, false, resumeState, matches);
+
+    // Add the discarded characters back once the open bounded token closes
+    // (The token itself and the matches that follow it were lexed without them)
+    if(discardedLength > 0 && consumed > tokenOffset)
+    {
+      const ParseOffset tokenStart = pendingOffset + tokenOffset;
+      for(ParseOffset c = firstMatch; c < matches.GetLength(); ++c)
+      {
+        if(matches[c].offset == tokenStart)
+          matches[c].length += (ParseLength)discardedLength;
+        else if(matches[c].offset > tokenStart)
+          matches[c].offset += discardedLength;
+      }
+      pendingOffset += discardedLength;
+      discardedLength = 0;
+    }
+    pendingOffset += consumed;
+
+    // Keep the characters that have not been consumed
+    if(input == chunk)
+      pending.assign(chunk + consumed, chunk + chunkLength);
+    else
+      pending.erase(pending.begin(), pending.begin() + consumed);
+
+    // Discard the characters of an open bounded token that have already been searched for its closing boundary
+    // (The opening boundary is kept so that the token is recognized again when lexing resumes)
+    ParseToken token;
+    Lexer::TokenType tokenType;
+    ParseOffset openingLength;
+    if(lexer.GetTrimmableToken(resumeState, token, tokenType, openingLength) && resumeState.searchOffset > openingLength)
+    {
+      // Lex the word before the token first: Lexing must resume at the token, since the symbols tried within the word would
+      // otherwise search the characters that follow it as well
+      if(resumeState.tokenOffset > 0)
+      {
+        Lexer::ResumeState wordResumeState;
+        lexer.LexicalAnalysis(&pending[0], resumeState.tokenOffset, 0, pendingOffset, resumeState.tokenOffset, true, wordResumeState, matches);
+        pending.erase(pending.begin(), pending.begin() + resumeState.tokenOffset);
+        pendingOffset += resumeState.tokenOffset;
+        resumeState.tokenOffset = 0;
+      }
+
+      pending.erase(pending.begin() + openingLength, pending.begin() + resumeState.searchOffset);
+      discardedLength += resumeState.searchOffset - openingLength;
+      resumeState.searchOffset = openingLength;
+    }
+  }
+
+  INLINE void LexerStream::Finish(Matches& matches)
+  {
+    ParseToken token;
+    Lexer::TokenType tokenType;
+    ParseOffset openingLength;
+    if(discardedLength > 0 && lexer.GetTrimmableToken(resumeState, token, tokenType, openingLength))
+    {
+      // The open bounded token (at the start of the pending characters) can not be lexed again without its discarded characters,
+      // so it is matched up to the end of the stream
+      // (This is the same match the lexer makes for a token without a closing boundary. An unterminated token with a closing boundary
+      //  would be lexed as ordinary characters instead if the whole input were available.)
+      if(tokenType != Lexer::TOKENTYPE_NIL)
+        matches.PushBack(ParseMatch(pendingOffset, (ParseLength)(pending.size() + discardedLength), token));
+      pendingOffset += (ParseOffset)pending.size() + discardedLength;
+    }
+    else if(!pending.empty())
+      pendingOffset += lexer.LexicalAnalysis(&pending[0], (ParseOffset)pending.size(), 0, pendingOffset, (ParseOffset)pending.size(), true, resumeState, matches);
+    pending.clear();
+    resumeState = Lexer::ResumeState();
+    discardedLength = 0;
+  }
+
+  INLINE void LexerStream::Reset()
+  {
+    pending.clear();
+    pendingOffset = 0;
+    resumeState = Lexer::ResumeState();
+    discardedLength = 0;
+  }
+}
+
+#endif
+#endif
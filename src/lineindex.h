@@ -0,0 +1,64 @@
+#ifndef __QPARSER_LINEINDEX_H__
+#define __QPARSER_LINEINDEX_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LINEINDEX.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      An index of the lines in the input. Maps offsets in the input (and
+      positions in the lex stream) to line and column numbers, for reporting
+      the locations of errors.
+
+    IMPLEMENTATION:
+      + The index stores the offset at which every line starts (in
+        ascending order). Newlines are found with the vectorized character
+        scanning routines, and a location is found by binary search.
+      + The lexer indexes the lines while it lexes the input, in blocks just
+        ahead of the parse position (see Lexer::LexicalAnalysis), so the
+        input is not scanned for newlines in a separate pass.
+      + Line and column numbers start at 1. Columns count characters (bytes)
+        from the start of the line.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class LineIndex
+  {
+  public:
+    // Construction (the index starts out holding a single line)
+    INLINE LineIndex();
+
+    // Remove all lines except the first
+    INLINE void Clear();
+
+    // Add the lines that start in [begin, end) of the input (parts of the input must be indexed in order)
+    INLINE void IndexLines(const_cstring input, ParseOffset begin, ParseOffset end);
+
+    // Add the lines of an index of a later part of the same input (the first line of that index is not added)
+    INLINE void Append(const LineIndex& lineIndex);
+
+    // Get the line and column of an offset in the input
+    INLINE void GetLocation(ParseOffset offset, uint& line, uint& column) const;
+
+    // Get the line and column of a lexical token (the end of the input for positions beyond the end of the lex stream)
+    INLINE void GetTokenLocation(const ParseResult& parseResult, ParseOffset lexIndex, uint& line, uint& column) const;
+
+    //// Accessors
+    INLINE uint GetLineCount() const { return (uint)lineStarts.size(); }
+    INLINE ParseOffset GetLineStart(uint line) const { return lineStarts[line - 1]; }
+
+  protected:
+    std::vector<ParseOffset> lineStarts; // The offset of the first character of every line
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "lineindex.inl"
+
+#endif
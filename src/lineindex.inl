@@ -0,0 +1,55 @@
+#ifdef  __QPARSER_LINEINDEX_H__
+#ifndef __QPARSER_LINEINDEX_INL__
+#define __QPARSER_LINEINDEX_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    LINEINDEX.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  INLINE LineIndex::LineIndex()
+  {
+    Clear();
+  }
+
+  INLINE void LineIndex::Clear()
+  {
+    lineStarts.assign(1, 0);
+  }
+
+  INLINE void LineIndex::IndexLines(const_cstring input, ParseOffset begin, ParseOffset end)
+  {
+    const_cstring const inputEnd = input + end;
+    const_cstring newline = CharScan::FindEither(input + begin, inputEnd, '\n', '\n');
+    while(newline != inputEnd)
+    {
+      lineStarts.push_back(ParseOffset(newline + 1 - input));
+      newline = CharScan::FindEither(newline + 1, inputEnd, '\n', '\n');
+    }
+  }
+
+  INLINE void LineIndex::Append(const LineIndex& lineIndex)
+  {
+    lineStarts.insert(lineStarts.end(), lineIndex.lineStarts.begin() + 1, lineIndex.lineStarts.end());
+  }
+
+  INLINE void LineIndex::GetLocation(ParseOffset offset, uint& line, uint& column) const
+  {
+    // Find the last line that starts at or before the offset
+    const std::vector<ParseOffset>::const_iterator i = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - 1;
+    line = uint(i - lineStarts.begin()) + 1;
+    column = uint(offset - *i) + 1;
+  }
+
+  INLINE void LineIndex::GetTokenLocation(const ParseResult& parseResult, ParseOffset lexIndex, uint& line, uint& column) const
+  {
+    GetLocation((lexIndex < parseResult.lexStream.length)? (ParseOffset)parseResult.lexStream.data[lexIndex].offset : parseResult.inputStream.length, line, column);
+  }
+}
+
+#endif
+#endif
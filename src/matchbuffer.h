@@ -0,0 +1,99 @@
+#ifndef __QPARSER_MATCHBUFFER_H__
+#define __QPARSER_MATCHBUFFER_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    MATCHBUFFER.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A growable array of parse matches (or of other stream elements, such
+      as the values of numeric literals) that the lexer writes its output
+      into directly.
+
+    IMPLEMENTATION:
+      + The buffer either uses memory provided by the caller or memory that
+        it owns (allocated with new[] so that it can be handed over to a
+        ParseResult stream without copying).
+      + Clearing the buffer keeps its memory, so that a single buffer can be
+        reused as an arena for the matches of many documents.
+      + If the caller's memory runs out, the matches are moved to memory
+        owned by the buffer.
+      + Memory handed over to a stream is trimmed to the number of matches
+        if much of it is unused (the capacity is estimated from the length
+        of the input and grows by half at a time), so that a lex stream
+        never keeps the slack of the estimate.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  template<typename Element>
+  class StreamBuffer
+  {
+  public:
+    // Construction / Destruction
+    INLINE StreamBuffer();
+    INLINE StreamBuffer(Element* data, ParseOffset capacity);
+    INLINE ~StreamBuffer();
+
+    // Add a match to the end of the buffer
+    FORCE_INLINE void PushBack(const Element& match) { if(length == capacity) Grow(length + 1); data[length++] = match; }
+
+    // Add a range of matches to the end of the buffer
+    INLINE void Append(const Element* begin, const Element* end);
+
+    // Replace count matches starting at index by a range of matches
+    INLINE void Replace(ParseOffset index, ParseOffset count, const Element* begin, const Element* end);
+
+    // Make sure that the buffer can hold at least the given number of matches without growing
+    INLINE void Reserve(ParseOffset capacity);
+
+    // Remove all matches (the memory is kept for reuse)
+    INLINE void Clear() { length = 0; }
+
+    // Exchange the contents of two buffers
+    INLINE void Swap(StreamBuffer& buffer);
+
+    // Transfer the matches to the caller (allocated with new[]; copied only if the buffer does not own its memory or if more than
+    // MAX_RELEASED_SLACK of it is unused). The buffer is left empty.
+    INLINE Element* Release();
+
+    //// Accessors
+    INLINE ParseOffset GetLength() const { return length; }
+    INLINE ParseOffset GetCapacity() const { return capacity; }
+    INLINE bool IsEmpty() const { return length == 0; }
+    INLINE bool IsOwner() const { return owner; }
+    INLINE Element* GetData() { return data; }
+    INLINE const Element* GetData() const { return data; }
+    FORCE_INLINE Element& operator[] (ParseOffset index) { return data[index]; }
+    FORCE_INLINE const Element& operator[] (ParseOffset index) const { return data[index]; }
+
+  protected:
+    static const ParseOffset MAX_RELEASED_SLACK = 4; // Released memory may hold up to 1/MAX_RELEASED_SLACK more matches than needed
+
+    Element* data;          // The matches
+    ParseOffset length;     // Number of matches in the buffer
+    ParseOffset capacity;   // Number of matches that fit into the memory of the buffer
+    bool owner;             // Flag indicating that the buffer owns its memory
+
+    // Move the matches to larger memory owned by the buffer
+    INLINE void Grow(ParseOffset minCapacity);
+
+  private:
+    // (Buffers are not copyable)
+    StreamBuffer(const StreamBuffer&);
+    StreamBuffer& operator = (const StreamBuffer&);
+  };
+
+  typedef StreamBuffer<ParseMatch> MatchBuffer;         // A buffer for a lex stream
+  typedef StreamBuffer<NumericLiteral> LiteralBuffer;   // A buffer for the values of the numeric literals in a lex stream (see Lexer::LexicalAnalysis)
+}
+
+/*                                   INCLUDES                               */
+#include "matchbuffer.inl"
+
+#endif
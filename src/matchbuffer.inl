@@ -0,0 +1,100 @@
+#ifdef  __QPARSER_MATCHBUFFER_H__
+#ifndef __QPARSER_MATCHBUFFER_INL__
+#define __QPARSER_MATCHBUFFER_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    MATCHBUFFER.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  template<typename Element> const ParseOffset StreamBuffer<Element>::MAX_RELEASED_SLACK;
+
+  template<typename Element> INLINE StreamBuffer<Element>::StreamBuffer() : data(null), length(0), capacity(0), owner(true) {}
+
+  template<typename Element> INLINE StreamBuffer<Element>::StreamBuffer(Element* data, ParseOffset capacity) : data(data), length(0), capacity(capacity), owner(false) {}
+
+  template<typename Element> INLINE StreamBuffer<Element>::~StreamBuffer()
+  {
+    if(owner)
+      delete[] data;
+  }
+
+  template<typename Element> INLINE void StreamBuffer<Element>::Append(const Element* begin, const Element* end)
+  {
+    const ParseOffset count = (ParseOffset)(end - begin);
+    if(length + count > capacity)
+      Grow(length + count);
+    if(count > 0)
+      memcpy(&data[length], begin, sizeof(Element) * count);
+    length += count;
+  }
+
+  template<typename Element> INLINE void StreamBuffer<Element>::Replace(ParseOffset index, ParseOffset count, const Element* begin, const Element* end)
+  {
+    const ParseOffset newCount = (ParseOffset)(end - begin);
+    if(length - count + newCount > capacity)
+      Grow(length - count + newCount);
+
+    // Move the matches that follow the replaced matches
+    if(newCount != count)
+      memmove(&data[index + newCount], &data[index + count], sizeof(Element) * (length - index - count));
+    if(newCount > 0)
+      memcpy(&data[index], begin, sizeof(Element) * newCount);
+    length = length - count + newCount;
+  }
+
+  template<typename Element> INLINE void StreamBuffer<Element>::Reserve(ParseOffset capacity)
+  {
+    if(capacity > StreamBuffer::capacity)
+      Grow(capacity);
+  }
+
+  template<typename Element> INLINE void StreamBuffer<Element>::Swap(StreamBuffer& buffer)
+  {
+    std::swap(data, buffer.data);
+    std::swap(length, buffer.length);
+    std::swap(capacity, buffer.capacity);
+    std::swap(owner, buffer.owner);
+  }
+
+  template<typename Element> INLINE Element* StreamBuffer<Element>::Release()
+  {
+    Element* matches = data;
+    if(!owner || capacity - length > length / MAX_RELEASED_SLACK)
+    {
+      // Copy the matches out of the caller's memory (or into memory of the exact size)
+      matches = new Element[length];
+      if(length > 0)
+        memcpy(matches, data, sizeof(Element) * length);
+      if(owner)
+        delete[] data;
+      owner = true;
+    }
+
+    data = null;
+    length = 0;
+    capacity = 0;
+    return matches;
+  }
+
+  template<typename Element> INLINE void StreamBuffer<Element>::Grow(ParseOffset minCapacity)
+  {
+    const ParseOffset newCapacity = std::max(minCapacity, capacity + capacity / 2);
+    Element* const newData = new Element[newCapacity];
+    if(length > 0)
+      memcpy(newData, data, sizeof(Element) * length);
+    if(owner)
+      delete[] data;
+
+    data = newData;
+    capacity = newCapacity;
+    owner = true;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,58 @@
+#ifndef __QPARSER_NUMERICLITERAL_H__
+#define __QPARSER_NUMERICLITERAL_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    NUMERICLITERAL.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      The decoded value of a numeric literal (an integer or a real number).
+
+    IMPLEMENTATION:
+      + Decimal and hexadecimal (0x) integers and decimal real numbers (with
+        an optional fraction and exponent) are recognized. Signs are not part
+        of a literal (the lexer separates them from the number).
+      + Real numbers with at most 19 significant digits and a small exponent
+        are converted exactly with a single multiplication or division by a
+        power of ten. All other real numbers are converted by strtod.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  struct NumericLiteral
+  {
+    // Types of numeric literals
+    enum LiteralType
+    {
+      LITERALTYPE_NONE    = 0, // Not a numeric literal
+      LITERALTYPE_INTEGER = 1, // An integer (stored in integer)
+      LITERALTYPE_REAL    = 2, // A real number (stored in real)
+      LITERALTYPE_INVALID = 3  // A literal that is not a valid number (or an integer that is out of range)
+    };
+
+    LiteralType type;   // The type of the literal
+    uint32 tokenCount;  // Number of lexical tokens spanned by the literal (e.g. 3 for "1" "." "5")
+    union
+    {
+      uint64 integer;   // The value of an integer literal
+      double real;      // The value of a real literal
+    };
+
+    // Decode the numeric literal at the start of [begin, end) (returns the end of the literal, or begin if there is none)
+    static INLINE const_cstring Decode(const_cstring begin, const_cstring end, NumericLiteral& literal);
+
+  protected:
+    static const uint MAX_MANTISSA_DIGITS = 19; // The largest number of decimal digits that always fits in a uint64
+    static const int MAX_EXACT_EXPONENT = 22;   // The largest power of ten that is exactly representable as a double
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "numericliteral.inl"
+
+#endif
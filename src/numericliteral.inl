@@ -0,0 +1,139 @@
+#ifdef  __QPARSER_NUMERICLITERAL_H__
+#ifndef __QPARSER_NUMERICLITERAL_INL__
+#define __QPARSER_NUMERICLITERAL_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    NUMERICLITERAL.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  const uint NumericLiteral::MAX_MANTISSA_DIGITS;
+  const int NumericLiteral::MAX_EXACT_EXPONENT;
+
+  INLINE const_cstring NumericLiteral::Decode(const_cstring begin, const_cstring end, NumericLiteral& literal)
+  {
+    const_cstring position = begin;
+    literal.type = LITERALTYPE_NONE;
+    literal.integer = 0;
+
+    if(position == end || *position < '0' || *position > '9')
+      return begin; // not a numeric literal
+
+    // Hexadecimal integer
+    if(end - position > 2 && position[0] == '0' && (position[1] == 'x' || position[1] == 'X') && isxdigit(uint8(position[2])))
+    {
+      uint64 value = 0;
+      literal.type = LITERALTYPE_INTEGER;
+      for(position += 2; position != end && isxdigit(uint8(*position)); ++position)
+      {
+        if(value >> 60 != 0)
+          literal.type = LITERALTYPE_INVALID; // (out of range)
+        const uint8 digit = uint8(*position);
+        value = (value << 4) | uint64((digit <= '9')? digit - '0' : (digit | 0x20) - 'a' + 10);
+      }
+      literal.integer = value;
+      return position;
+    }
+
+    // Mantissa (keeping the first MAX_MANTISSA_DIGITS significant digits)
+    uint64 mantissa = 0;
+    uint nDigits = 0;
+    bool truncated = false;
+    int exponent = 0;
+    for(; position != end && *position >= '0' && *position <= '9'; ++position)
+    {
+      if(nDigits < MAX_MANTISSA_DIGITS)
+      {
+        mantissa = mantissa * 10 + uint64(*position - '0');
+        nDigits += (mantissa != 0);
+      }
+      else
+      {
+        ++exponent;
+        truncated = true;
+      }
+    }
+    const_cstring const integerEnd = position;
+
+    // Fraction
+    bool real = false;
+    if(end - position > 1 && position[0] == '.' && position[1] >= '0' && position[1] <= '9')
+    {
+      real = true;
+      for(++position; position != end && *position >= '0' && *position <= '9'; ++position)
+      {
+        if(nDigits < MAX_MANTISSA_DIGITS)
+        {
+          mantissa = mantissa * 10 + uint64(*position - '0');
+          nDigits += (mantissa != 0);
+          --exponent;
+        }
+        else
+          truncated = true;
+      }
+    }
+
+    // Exponent
+    if(position != end && (*position == 'e' || *position == 'E'))
+    {
+      const_cstring exponentPosition = position + 1;
+      bool negative = false;
+      if(exponentPosition != end && (*exponentPosition == '+' || *exponentPosition == '-'))
+      {
+        negative = (*exponentPosition == '-');
+        ++exponentPosition;
+      }
+
+      if(exponentPosition != end && *exponentPosition >= '0' && *exponentPosition <= '9')
+      {
+        int explicitExponent = 0;
+        for(; exponentPosition != end && *exponentPosition >= '0' && *exponentPosition <= '9'; ++exponentPosition)
+          if(explicitExponent < 100000)
+            explicitExponent = explicitExponent * 10 + (*exponentPosition - '0');
+        exponent += negative? -explicitExponent : explicitExponent;
+        position = exponentPosition;
+        real = true;
+      }
+    }
+
+    if(!real)
+    {
+      // Integer (the digits must fit in a uint64 without truncation)
+      uint64 value = 0;
+      literal.type = LITERALTYPE_INTEGER;
+      for(const_cstring digit = begin; digit != integerEnd; ++digit)
+      {
+        const uint64 digitValue = uint64(*digit - '0');
+        if(value > (~uint64(0) - digitValue) / 10)
+          literal.type = LITERALTYPE_INVALID; // (out of range)
+        value = value * 10 + digitValue;
+      }
+      literal.integer = value;
+      return position;
+    }
+
+    literal.type = LITERALTYPE_REAL;
+    static const double POWERS_OF_TEN[MAX_EXACT_EXPONENT + 1] =
+    {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    if(!truncated && mantissa <= (uint64(1) << 53) && exponent >= -MAX_EXACT_EXPONENT && exponent <= MAX_EXACT_EXPONENT)
+    {
+      // (Both the mantissa and the power of ten are exact, so a single rounding produces the correctly rounded value)
+      literal.real = (exponent < 0)? double(mantissa) / POWERS_OF_TEN[-exponent] : double(mantissa) * POWERS_OF_TEN[exponent];
+      return position;
+    }
+
+    const std::string text(begin, position);
+    literal.real = strtod(text.c_str(), null);
+    return position;
+  }
+}
+
+#endif
+#endif
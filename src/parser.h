@@ -38,6 +38,24 @@ namespace QParser
     // Tokens
     INLINE TokenRegistry& GetTokenRegistry() { return tokenRegistry; }
     INLINE const TokenRegistry& GetTokenRegistry() const { return tokenRegistry; }
+
+    // Take an immutable snapshot of the token registry which can be shared with other parsers and threads
+    // (A new snapshot is only taken if tokens were added since the last one. It replaces the previous snapshot, whose names
+    //  remain valid only for as long as someone else holds on to it.)
+    INLINE const std::shared_ptr<const FrozenTokenRegistry>& FreezeTokenRegistry();
+    INLINE const std::shared_ptr<const FrozenTokenRegistry>& GetFrozenTokenRegistry() const { return frozenTokenRegistry; }
+
+    // Adopt a snapshot of a token registry shared with other parsers (e.g. one taken by a parser of the same language). The token
+    // registry is built against the snapshot (see TokenRegistry::SetBase): The lexer and grammar find the snapshot's tokens in it
+    // instead of registering (and storing) them again, and any other tokens are assigned after them. This must be done before any
+    // tokens are registered.
+    INLINE void AdoptTokenRegistry(const std::shared_ptr<const FrozenTokenRegistry>& tokenRegistry);
+
+    // Look up tokens and their names (in the token registry, or the snapshot it was built against)
+    INLINE ParseToken GetToken(const_cstring tokenName, uint nameLength) const;
+    INLINE const_cstring GetTokenName(ParseToken token) const;
+    INLINE bool IsTerminal(ParseToken token) const;
+    INLINE bool IsTokenValid(ParseToken token) const;
     
     // Lexing
     //INLINE Lexer& GetLexer() { return lexer; }
@@ -65,6 +83,7 @@ namespace QParser
 
   protected:
     TokenRegistry tokenRegistry;  // A registry of the tokens used by both the parser and the lexer
+    std::shared_ptr<const FrozenTokenRegistry> frozenTokenRegistry; // The last snapshot of the token registry (see FreezeTokenRegistry and AdoptTokenRegistry)
     //Lexer lexer;                  // The lexer used to tokenize the incoming stream of characters
     
     // Streams for parser messages to be output
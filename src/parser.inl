@@ -31,6 +31,44 @@ namespace QParser
     delete infoStream.rdbuf(null);
   }
 
+  INLINE const std::shared_ptr<const FrozenTokenRegistry>& ParserImplementation::FreezeTokenRegistry()
+  {
+    // (An adopted snapshot is kept unless tokens were registered beyond it)
+    if(!frozenTokenRegistry
+      || tokenRegistry.GetNextAvailableTerminal() > frozenTokenRegistry->GetNextAvailableTerminal()
+      || tokenRegistry.GetNextAvailableNonterminal() > frozenTokenRegistry->GetNextAvailableNonterminal())
+      frozenTokenRegistry = tokenRegistry.Freeze();
+    return frozenTokenRegistry;
+  }
+
+  INLINE void ParserImplementation::AdoptTokenRegistry(const std::shared_ptr<const FrozenTokenRegistry>& tokenRegistry)
+  {
+    // (The token registry must still be empty, otherwise its tokens would collide with those of the snapshot)
+    OSI_ASSERT(ParserImplementation::tokenRegistry.IsEmpty());
+    ParserImplementation::tokenRegistry.SetBase(tokenRegistry);
+    frozenTokenRegistry = tokenRegistry;
+  }
+
+  INLINE ParseToken ParserImplementation::GetToken(const_cstring tokenName, uint nameLength) const
+  {
+    return tokenRegistry.GetToken(tokenName, nameLength);
+  }
+
+  INLINE const_cstring ParserImplementation::GetTokenName(ParseToken token) const
+  {
+    return tokenRegistry.GetTokenName(token);
+  }
+
+  INLINE bool ParserImplementation::IsTerminal(ParseToken token) const
+  {
+    return TokenRegistry::IsTerminal(token);
+  }
+
+  INLINE bool ParserImplementation::IsTokenValid(ParseToken token) const
+  {
+    return tokenRegistry.IsTokenValid(token);
+  }
+
   /*void ParserImplementation::ConstructTokens()
   {
     uint&             nTokens                      = ParserImplementation::nTokens[activeTokenType + activeSubTokenType];
@@ -61,7 +99,7 @@ namespace QParser
 
           // Copy construction token into active tokens array
           // todo: this is rather ugly and inefficient... we should rewrite this using some indexing library
-          TokenRootIndex& tokenRootIndex = activeTokenRootIndices[uint(rootCharacter)];
+          TokenRootIndex& tokenRootIndex = activeTokenRootIndices[uint8(rootCharacter)];
           if(tokenRootIndex.length == 0)
           {
             tokenRootIndex.offset = cToken;
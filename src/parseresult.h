@@ -12,16 +12,55 @@
     DESCRIPTION:
       QParser parse result structure. Describes the outputs (and inputs) of 
       the parser.
+
+    IMPLEMENTATION:
+      + By default parse matches use the compact OSIX::ParseMatch layout,
+        which limits match lengths to 64 KB. Define QPARSER_WIDE_OFFSETS as
+        32 or 64 to carry 32-bit or 64-bit offsets and lengths through the
+        parse result, the lexer and the recognizer instead. (Note that
+        clients of the OpenParser API must then use the stream's
+        elementSize to step through the matches)
 */
 
+/*                              COMPILER MACROS                             */
+#if defined(QPARSER_WIDE_OFFSETS) && QPARSER_WIDE_OFFSETS != 32 && QPARSER_WIDE_OFFSETS != 64
+# error "QPARSER_WIDE_OFFSETS must be defined as either 32 or 64"
+#endif
+
 /*                                  CLASSES                                 */
 namespace QParser
 {
+  // Offsets into (and lengths of matches in) the input and lex streams
+#if !defined(QPARSER_WIDE_OFFSETS)
+  typedef decltype(OSIX::ParseMatch::offset) ParseOffset;
+  typedef decltype(OSIX::ParseMatch::length) ParseLength;
+#elif QPARSER_WIDE_OFFSETS == 32
+  typedef uint32 ParseOffset;
+  typedef uint32 ParseLength;
+#else
+  typedef uint64 ParseOffset;
+  typedef uint64 ParseLength;
+#endif
+
+#if !defined(QPARSER_WIDE_OFFSETS)
   struct ParseMatch : public OSIX::ParseMatch
   {
-    FORCE_INLINE ParseMatch(uint16 offset, uint16 length, ParseToken token) { ParseMatch::offset = offset; ParseMatch::length = length; ParseMatch::token = token; }
+    FORCE_INLINE ParseMatch(ParseOffset offset, ParseLength length, ParseToken token) { ParseMatch::offset = offset; ParseMatch::length = length; ParseMatch::token = token; }
+    INLINE ParseMatch() {}
+  };
+#else
+  struct ParseMatch
+  {
+    ParseToken  token;  // The matched token
+    ParseOffset offset; // Offset of the match in the input (or lex) stream
+    ParseLength length; // Length of the match
+
+    FORCE_INLINE ParseMatch(ParseOffset offset, ParseLength length, ParseToken token) : token(token), offset(offset), length(length) {}
     INLINE ParseMatch() {}
   };
+#endif
+
+  class LineIndex;
   
   class ParseResult : public Base::Object
   {
@@ -29,11 +68,12 @@ namespace QParser
     // Input data
     template<typename Type> struct Stream
     {
-      uint  length;       // Number of elements in the stream
-      uint  elementSize;  // Size of a single element in the stream
-      Type* data;         // Data contained in the stream
+      ParseOffset length;       // Number of elements in the stream
+      uint        elementSize;  // Size of a single element in the stream
+      Type*       data;         // Data contained in the stream
     };
     Stream<const char> inputStream;
+    uint inputPadding; // Number of zero characters that follow the input stream (see Lexer::GetInputPadding)
 
     // Parse matches
     Stream<ParseMatch> parseStream;
@@ -42,13 +82,40 @@ namespace QParser
     // Lexical token matches
     Stream<ParseMatch> lexStream;
 
+    // Interned identifiers (optional)
+    SymbolTable* symbolTable;                   // The table into which the lexer interns identifiers (null if identifiers should not be interned)
+    Stream<SymbolTable::SymbolId> symbolStream; // The symbol of every lexical token (parallel to lexStream; SYMBOL_NONE for tokens that are not identifiers)
+
+    // Decoded numeric literals (optional)
+    bool decodeLiterals;                        // Flag indicating that the lexer should decode numeric literals
+    Stream<NumericLiteral> literalStream;       // The value of every lexical token (parallel to lexStream; LITERALTYPE_NONE for tokens that are not literals)
+
+    // Silent tokens (see Lexer::SetSilentTerminals)
+    Stream<uint64> silentMask;                  // One bit per lexical token (bit c % 64 of element c / 64), set for silent tokens that the parser must still shift (empty if there are none)
+
+    // UTF-8 validation (optional)
+    bool validateUtf8;                          // Flag indicating that the lexer should validate the input as UTF-8
+    ParseOffset invalidUtf8Offset;              // Offset of the first invalid UTF-8 sequence in the input (the length of the input if it is valid)
+
+    // Line index (optional)
+    LineIndex* lineIndex;                       // The index into which the lexer records the start of every line (null if lines should not be indexed)
+
     ParseResult() 
     { 
       memset(&inputStream, 0, sizeof(inputStream));
       memset(&parseStream, 0, sizeof(parseStream));
       memset(&lexStream, 0, sizeof(lexStream));
+      memset(&symbolStream, 0, sizeof(symbolStream));
+      memset(&literalStream, 0, sizeof(literalStream));
+      memset(&silentMask, 0, sizeof(silentMask));
+      inputPadding = 0;
+      symbolTable = null;
+      lineIndex = null;
+      decodeLiterals = false;
+      validateUtf8 = false;
+      invalidUtf8Offset = 0;
     }
-    virtual ~ParseResult() { delete[] parseStream.data; delete[] lexStream.data; }
+    virtual ~ParseResult() { delete[] parseStream.data; delete[] lexStream.data; delete[] symbolStream.data; delete[] literalStream.data; delete[] silentMask.data; }
   };
 }
 
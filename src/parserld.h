@@ -65,12 +65,30 @@ namespace QParser
 
     // Parse
     virtual void Parse(ParseResult& parseResult);
+
+    // Parse the input stream of the parse result, lexing each token on demand with only the terminals that the parser can accept
+    // at that point (see Lexer::ContextualAnalysis). The lex stream of the parse result is replaced by the tokens lexed.
+    void Parse(ParseResult& parseResult, const Lexer& lexer);
       
   protected:
     ParseTokens parseTable;
+
+    // Contextual lexing
+    static const uint TERMINALSET_NONE = ~0u;
+    std::vector<TerminalSet> terminalSets;  // The sets of terminals accepted by the parse actions that read a lexical token
+    std::vector<uint> terminalSetIndices;   // The terminal set of every entry in the parse table (TERMINALSET_NONE for entries that do not read a token)
+
+    // Build the terminal sets accepted by the shift, pivot and accept actions of the parse table
+    void BuildTerminalSets();
     
     // Perform the recognition pass
     void RecognitionPass(ParseResult& parseResult, ParseTokens& rules);
+
+    // Perform the recognition pass, lexing each token on demand into tokenMatches if a lexer is given (null if the lex stream should be read instead)
+    void RecognitionPass(ParseResult& parseResult, ParseTokens& rules, const Lexer* lexer, MatchBuffer& tokenMatches);
+
+    // Print the location of a lexical token to the error stream (when the parse result has a line index)
+    void PrintLocation(const ParseResult& parseResult, ParseOffset lexIndex);
     
     // Construct the abstract syntax tree using the rules given from the recognition pass
     void ConstructAST(ParseResult& parseResult, ParseTokens& rules);
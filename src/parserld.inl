@@ -18,11 +18,68 @@ namespace QParser
       delete *i;*/
   }
   
+  const uint ParserLD::TERMINALSET_NONE;
+
   void ParserLD::ConstructParser(Grammar* grammar)
   {
     GrammarLD *grammarLD = dynamic_cast<GrammarLD*>(grammar);
     if (grammarLD)
+    {
       grammarLD->ConstructParseTable(parseTable);
+      BuildTerminalSets();
+    }
+  }
+
+  void ParserLD::BuildTerminalSets()
+  {
+    terminalSets.clear();
+    terminalSetIndices.assign(parseTable.size(), TERMINALSET_NONE);
+
+    // The accept action only accepts the end of the input (an empty set)
+    terminalSets.push_back(TerminalSet());
+    const uint acceptSet = 0;
+
+    // Shift actions of the same terminal share a set
+    std::map<ParseToken, uint> shiftSets;
+
+    // Step through the actions of the parse table (skipping the operands of pivot and goto actions)
+    for(uint cAction = 0; cAction < parseTable.size(); ++cAction)
+    {
+      const ParseToken parseAction = parseTable[cAction];
+      switch(parseAction)
+      {
+        case TOKEN_ACTION_PIVOT:
+        {
+          // A pivot accepts the terminals of all its branches
+          const ParseToken nPivots = parseTable[cAction + 1];
+          terminalSetIndices[cAction] = (uint)terminalSets.size();
+          terminalSets.push_back(TerminalSet());
+          for(uint c = 0; c < nPivots; ++c)
+            terminalSets.back().Add(parseTable[cAction + 2 + 2*c]);
+          cAction += 1 + 2*nPivots;
+          continue;
+        }
+        case TOKEN_ACTION_GOTO:
+          cAction += 2;
+          continue;
+        case TOKEN_ACTION_ACCEPT:
+          terminalSetIndices[cAction] = acceptSet;
+          continue;
+      }
+
+      // A shift action accepts a single terminal
+      if(parseAction < TOKEN_RESERVED_TOKENS && (parseAction & TOKEN_FLAG_SHIFT))
+      {
+        std::map<ParseToken, uint>::const_iterator i = shiftSets.find(parseAction);
+        if(i == shiftSets.end())
+        {
+          i = shiftSets.insert(std::make_pair(parseAction, (uint)terminalSets.size())).first;
+          terminalSets.push_back(TerminalSet());
+          terminalSets.back().Add(parseAction);
+        }
+        terminalSetIndices[cAction] = i->second;
+      }
+    }
   }
 
   void ParserLD::Parse(ParseResult& parseResult)
@@ -39,8 +96,50 @@ namespace QParser
     // Perform the final parse tree construction pass
     ConstructAST(parseResult, rules);
   }
+
+  void ParserLD::Parse(ParseResult& parseResult, const Lexer& lexer)
+  {
+    if(parseTable.size() == 0)
+      return; // todo: error, parse table is empty (no grammar defined)
+
+    // Index the lines of the input (the lexer only does so when it lexes the whole input)
+    if(parseResult.lineIndex != null)
+    {
+      parseResult.lineIndex->Clear();
+      parseResult.lineIndex->IndexLines(parseResult.inputStream.data, 0, parseResult.inputStream.length);
+    }
+
+    // Validate the input as UTF-8 (the lexer only does so when it lexes the whole input)
+    if(parseResult.validateUtf8)
+      parseResult.invalidUtf8Offset = (ParseOffset)(CharScan::FindInvalidUtf8(parseResult.inputStream.data, parseResult.inputStream.data + parseResult.inputStream.length) - parseResult.inputStream.data);
+
+    // Perform the recognition pass (lexing on demand)
+    // (The lex stream of the parse result refers to the tokens lexed so far during the pass, so that errors can be located)
+    delete[] parseResult.lexStream.data;
+    parseResult.lexStream.data = null;
+    parseResult.lexStream.length = 0;
+    parseResult.lexStream.elementSize = sizeof(ParseMatch);
+
+    MatchBuffer tokenMatches;
+    ParseTokens rules;
+    RecognitionPass(parseResult, rules, &lexer, tokenMatches);
+
+    // Hand the lexed tokens over to the parse result
+    parseResult.lexStream.length = tokenMatches.GetLength();
+    parseResult.lexStream.data = tokenMatches.Release();
+    lexer.MaskSilentTokens(parseResult);
+
+    // Perform the final parse tree construction pass
+    ConstructAST(parseResult, rules);
+  }
   
   void ParserLD::RecognitionPass(ParseResult& parseResult, ParseTokens& rules)
+  {
+    MatchBuffer tokenMatches;
+    RecognitionPass(parseResult, rules, null, tokenMatches);
+  }
+
+  void ParserLD::RecognitionPass(ParseResult& parseResult, ParseTokens& rules, const Lexer* lexer, MatchBuffer& tokenMatches)
   {
     rules.clear();
     
@@ -52,7 +151,8 @@ namespace QParser
     std::stack<ParseToken> delayedStates; // The position of each ignore token reduced (which still needs to be resolved)
             
     // Lexical stream state
-    uint16 lexState = 0;              // The current position in the lex stream
+    ParseOffset lexState = 0;         // The current position in the lex stream
+    ParseOffset inputPosition = 0;    // The current position in the input stream (when lexing on demand)
     ParseToken lexToken = 0;          // The last token read from the lex stream
     
     bool skipReadingToken = false;     // A flag that allows the algorithm to skip reading a token from the lex stream
@@ -60,18 +160,32 @@ namespace QParser
     // Perform the recognition
     while(true)
     {
-      if (!skipReadingToken)
+      // Read a parse action from the parse table
+      parseAction = parseTable[parseState];
+
+      // When lexing on demand, the next token is only lexed once an action that reads it is reached, so that only the
+      // terminals that the action accepts are tried
+      // (The other actions never match the last token read: it is a terminal or the end of the input)
+      if (!skipReadingToken && (lexer == null || lexState < parseResult.lexStream.length || terminalSetIndices[parseState] != TERMINALSET_NONE))
       {
+        if(lexer != null && lexState == parseResult.lexStream.length)
+        {
+          ParseMatch tokenMatch;
+          if(lexer->ContextualAnalysis(parseResult.inputStream.data, parseResult.inputStream.length, parseResult.inputPadding, inputPosition, terminalSets[terminalSetIndices[parseState]], tokenMatch))
+          {
+            tokenMatches.PushBack(tokenMatch);
+            parseResult.lexStream.data = tokenMatches.GetData();
+            parseResult.lexStream.length = tokenMatches.GetLength();
+          }
+        }
+
         // Read a lexical token from the stream
         lexToken = (lexState < parseResult.lexStream.length? parseResult.lexStream.data[lexState].token : TOKEN_SPECIAL_EOF);
 #ifdef QPARSER_TEST_ParserLD
         infoStream << "Read lexical token (" << (lexToken & (~TOKEN_FLAG_SHIFT)) << ')' << std::endl;
 #endif
+        skipReadingToken = true;
       }
-      skipReadingToken = true;
-
-      // Read a parse action from the parse table
-      parseAction = parseTable[parseState];
       
       // Recognize a terminal token
       // (Perform a shift action)
@@ -136,7 +250,9 @@ namespace QParser
         if(parseAction&TOKEN_FLAG_SHIFT)
         {
           // ERROR: Expected lexToken
-          errorStream << "Unexpected token, at line [???] in program [???]" << std::endl;            
+          errorStream << "Unexpected token, at ";
+          PrintLocation(parseResult, lexState);
+          errorStream << " in program [???]" << std::endl;            
           errorStream << "-> Expected: " << (parseAction & (~TOKEN_FLAG_SHIFT)) << std::endl;          
           return;
         }
@@ -191,7 +307,9 @@ namespace QParser
             returnStates.pop();
             
             // ERROR: Expected lexToken
-            errorStream << "Unexpected token, at line [???] in program [???]" << std::endl;            
+            errorStream << "Unexpected token, at ";
+            PrintLocation(parseResult, lexState);
+            errorStream << " in program [???]" << std::endl;            
             errorStream << "-> Expected one of: ";
             for(uint c = 0; c < nPivots; ++c)
             {
@@ -255,7 +373,9 @@ namespace QParser
           if(lexToken != TOKEN_SPECIAL_EOF)
           {
             // ERROR: End-of-file expected
-            errorStream << "Unexpected token, at line [???] in program [???]" << std::endl;            
+            errorStream << "Unexpected token, at ";
+            PrintLocation(parseResult, lexState);
+            errorStream << " in program [???]" << std::endl;            
             errorStream << "-> Expected end of file" << std::endl;
             return;
           }          
@@ -265,6 +385,19 @@ namespace QParser
     }
   }
   
+  void ParserLD::PrintLocation(const ParseResult& parseResult, ParseOffset lexIndex)
+  {
+    if(parseResult.lineIndex == null)
+    {
+      errorStream << "line [???]";
+      return;
+    }
+
+    uint line, column;
+    parseResult.lineIndex->GetTokenLocation(parseResult, lexIndex, line, column);
+    errorStream << "line " << line << ", column " << column;
+  }
+  
   void ParserLD::ConstructAST(ParseResult& parseResult, ParseTokens& rules)
   {
     std::stack<uint> ruleChildCount;
@@ -0,0 +1,93 @@
+#ifndef __QPARSER_REGEX_H__
+#define __QPARSER_REGEX_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    REGEX.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A parsed regular expression (used to define lexical tokens by a
+      pattern instead of a fixed string).
+
+    IMPLEMENTATION:
+      + The pattern is parsed into a tree of nodes (character sets,
+        concatenations, alternations and repetitions) by recursive descent.
+        The lexer automaton is built from the tree (see LexerDFA::AddRegex).
+      + Supported syntax: literal characters, '.' (any character except a
+        newline), sets ("[a-z_]", "[^\"]"), the escapes \n \r \t \f \v
+        \xHH \d \D \w \W \s \S (any other escaped character stands for
+        itself), grouping "( )", alternation "|" and the repetitions
+        "*", "+", "?", "{m}", "{m,}" and "{m,n}".
+      + No character set contains the zero character (the lexer relies on
+        the zero characters that pad its input never being matched).
+      + Patterns that match the empty string are rejected, since a token
+        must consume at least one character.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class Regex
+  {
+  public:
+    // Types of nodes in the syntax tree
+    enum NodeType
+    {
+      NODETYPE_CHARACTERS    = 0, // Matches a single character of a set
+      NODETYPE_CONCATENATION = 1, // Matches the left node followed by the right node
+      NODETYPE_ALTERNATION   = 2, // Matches either the left node or the right node
+      NODETYPE_REPETITION    = 3  // Matches the left node minCount to maxCount times
+    };
+
+    // A node in the syntax tree
+    struct Node
+    {
+      NodeType type;
+      uint left, right;       // Indices of the child nodes
+      uint minCount;          // The least number of repetitions
+      uint maxCount;          // The largest number of repetitions (REPETITION_UNBOUNDED for no limit)
+      CharClass characters;   // The characters matched (character nodes only)
+    };
+
+    static const uint REPETITION_UNBOUNDED = ~uint(0);
+    static const uint MAX_REPETITION_COUNT = 1000; // The largest count accepted in a "{m,n}" repetition
+
+    // Construction
+    INLINE Regex() : root(0) {}
+
+    // Parse a pattern (returns false if the pattern is not a valid regular expression or matches the empty string)
+    INLINE bool Parse(const_cstring pattern);
+
+    //// Accessors
+    INLINE uint GetRoot() const { return root; }
+    INLINE const Node& GetNode(uint node) const { return nodes[node]; }
+
+  protected:
+    std::vector<Node> nodes;  // All nodes of the syntax tree
+    uint root;                // The root node
+
+    // Recursive descent parser (each routine returns false on a syntax error)
+    INLINE bool ParseAlternation(const_cstring& position, uint& node);
+    INLINE bool ParseConcatenation(const_cstring& position, uint& node);
+    INLINE bool ParseRepetition(const_cstring& position, uint& node);
+    INLINE bool ParseAtom(const_cstring& position, uint& node);
+    INLINE bool ParseSet(const_cstring& position, CharClass& characters);
+    INLINE bool ParseEscape(const_cstring& position, CharClass& characters);
+    static INLINE bool ParseCount(const_cstring& position, uint& count);
+
+    // Add a node to the syntax tree
+    INLINE uint AddNode(NodeType type, uint left, uint right);
+
+    // Test whether a node matches the empty string
+    INLINE bool IsNullable(uint node) const;
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "regex.inl"
+
+#endif
@@ -0,0 +1,313 @@
+#ifdef  __QPARSER_REGEX_H__
+#ifndef __QPARSER_REGEX_INL__
+#define __QPARSER_REGEX_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    REGEX.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  const uint Regex::REPETITION_UNBOUNDED;
+  const uint Regex::MAX_REPETITION_COUNT;
+
+  INLINE bool Regex::Parse(const_cstring pattern)
+  {
+    nodes.clear();
+    root = 0;
+
+    const_cstring position = pattern;
+    if(!ParseAlternation(position, root) || *position != '\0')
+    {
+      nodes.clear();
+      return false;
+    }
+
+    // A token must consume at least one character
+    if(IsNullable(root))
+    {
+      nodes.clear();
+      return false;
+    }
+    return true;
+  }
+
+  INLINE bool Regex::ParseAlternation(const_cstring& position, uint& node)
+  {
+    if(!ParseConcatenation(position, node))
+      return false;
+
+    while(*position == '|')
+    {
+      ++position;
+      uint right;
+      if(!ParseConcatenation(position, right))
+        return false;
+      node = AddNode(NODETYPE_ALTERNATION, node, right);
+    }
+    return true;
+  }
+
+  INLINE bool Regex::ParseConcatenation(const_cstring& position, uint& node)
+  {
+    // (Empty alternatives and groups are not supported)
+    if(!ParseRepetition(position, node))
+      return false;
+
+    while(*position != '\0' && *position != '|' && *position != ')')
+    {
+      uint right;
+      if(!ParseRepetition(position, right))
+        return false;
+      node = AddNode(NODETYPE_CONCATENATION, node, right);
+    }
+    return true;
+  }
+
+  INLINE bool Regex::ParseRepetition(const_cstring& position, uint& node)
+  {
+    if(!ParseAtom(position, node))
+      return false;
+
+    while(true)
+    {
+      uint minCount, maxCount;
+      switch(*position)
+      {
+      case '*': minCount = 0; maxCount = REPETITION_UNBOUNDED; ++position; break;
+      case '+': minCount = 1; maxCount = REPETITION_UNBOUNDED; ++position; break;
+      case '?': minCount = 0; maxCount = 1; ++position; break;
+      case '{':
+        ++position;
+        if(!ParseCount(position, minCount))
+          return false;
+        maxCount = minCount;
+        if(*position == ',')
+        {
+          ++position;
+          if(*position == '}')
+            maxCount = REPETITION_UNBOUNDED;
+          else if(!ParseCount(position, maxCount) || maxCount < minCount)
+            return false;
+        }
+        if(*position != '}')
+          return false;
+        ++position;
+        break;
+      default:
+        return true;
+      }
+
+      node = AddNode(NODETYPE_REPETITION, node, 0);
+      nodes[node].minCount = minCount;
+      nodes[node].maxCount = maxCount;
+    }
+  }
+
+  INLINE bool Regex::ParseAtom(const_cstring& position, uint& node)
+  {
+    switch(*position)
+    {
+    case '(':
+      ++position;
+      if(!ParseAlternation(position, node) || *position != ')')
+        return false;
+      ++position;
+      return true;
+
+    case '\0': case '|': case ')': case '*': case '+': case '?': case '{':
+      return false; // (an atom is missing)
+    }
+
+    node = AddNode(NODETYPE_CHARACTERS, 0, 0);
+    CharClass characters;
+    switch(*position)
+    {
+    case '[':
+      ++position;
+      if(!ParseSet(position, characters))
+        return false;
+      break;
+
+    case '.':
+      ++position;
+      characters.Invert();
+      characters.Remove('\n');
+      break;
+
+    case '\\':
+      ++position;
+      if(!ParseEscape(position, characters))
+        return false;
+      break;
+
+    default:
+      characters.Add(uint8(*position));
+      ++position;
+    }
+
+    characters.Remove('\0');
+    nodes[node].characters = characters;
+    return true;
+  }
+
+  INLINE bool Regex::ParseSet(const_cstring& position, CharClass& characters)
+  {
+    const bool negated = (*position == '^');
+    if(negated)
+      ++position;
+
+    // (A ']' directly after the opening bracket is a member of the set)
+    bool first = true;
+    while(*position != ']' || first)
+    {
+      first = false;
+      if(*position == '\0')
+        return false;
+
+      // Parse a single character (or an escaped class such as \d)
+      CharClass member;
+      if(*position == '\\')
+      {
+        ++position;
+        if(!ParseEscape(position, member))
+          return false;
+      }
+      else
+      {
+        member.Add(uint8(*position));
+        ++position;
+      }
+
+      // Parse a range of characters
+      if(*position == '-' && position[1] != ']' && position[1] != '\0')
+      {
+        uint low = 0;
+        while(low <= MAX_UINT8 && !member.Contains(uint8(low)))
+          ++low;
+        ++position;
+
+        CharClass highMember;
+        if(*position == '\\')
+        {
+          ++position;
+          if(!ParseEscape(position, highMember))
+            return false;
+        }
+        else
+        {
+          highMember.Add(uint8(*position));
+          ++position;
+        }
+        uint high = MAX_UINT8;
+        while(high > 0 && !highMember.Contains(uint8(high)))
+          --high;
+
+        if(low > high)
+          return false;
+        for(uint c = low; c <= high; ++c)
+          member.Add(uint8(c));
+      }
+
+      for(uint c = 0; c <= MAX_UINT8; ++c)
+        if(member.Contains(uint8(c)))
+          characters.Add(uint8(c));
+    }
+    ++position;
+
+    if(negated)
+      characters.Invert();
+    return true;
+  }
+
+  INLINE bool Regex::ParseEscape(const_cstring& position, CharClass& characters)
+  {
+    const char escaped = *position;
+    if(escaped == '\0')
+      return false;
+    ++position;
+
+    switch(escaped)
+    {
+    case 'n': characters.Add('\n'); return true;
+    case 'r': characters.Add('\r'); return true;
+    case 't': characters.Add('\t'); return true;
+    case 'f': characters.Add('\f'); return true;
+    case 'v': characters.Add('\v'); return true;
+
+    case 'x':
+      {
+        uint value = 0;
+        for(uint c = 0; c < 2; ++c, ++position)
+        {
+          if(!isxdigit(uint8(*position)))
+            return false;
+          value = value * 16 + (isdigit(uint8(*position))? *position - '0' : (tolower(uint8(*position)) - 'a' + 10));
+        }
+        characters.Add(uint8(value));
+        return true;
+      }
+
+    case 'd': case 'D': case 'w': case 'W': case 's': case 'S':
+      for(uint c = 1; c <= MAX_UINT8; ++c)
+      {
+        const bool member = (tolower(escaped) == 'd')? (c >= '0' && c <= '9')
+          : (tolower(escaped) == 'w')? ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+          : (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v');
+        if(member != (isupper(escaped) != 0))
+          characters.Add(uint8(c));
+      }
+      return true;
+    }
+
+    characters.Add(uint8(escaped));
+    return true;
+  }
+
+  INLINE bool Regex::ParseCount(const_cstring& position, uint& count)
+  {
+    if(!isdigit(uint8(*position)))
+      return false;
+
+    count = 0;
+    while(isdigit(uint8(*position)))
+    {
+      count = count * 10 + (*position - '0');
+      if(count > MAX_REPETITION_COUNT)
+        return false;
+      ++position;
+    }
+    return true;
+  }
+
+  INLINE uint Regex::AddNode(NodeType type, uint left, uint right)
+  {
+    nodes.push_back(Node());
+    Node& node = nodes.back();
+    node.type = type;
+    node.left = left;
+    node.right = right;
+    node.minCount = 1;
+    node.maxCount = 1;
+    return uint(nodes.size() - 1);
+  }
+
+  INLINE bool Regex::IsNullable(uint node) const
+  {
+    const Node& n = nodes[node];
+    switch(n.type)
+    {
+    case NODETYPE_CHARACTERS:    return false;
+    case NODETYPE_CONCATENATION: return IsNullable(n.left) && IsNullable(n.right);
+    case NODETYPE_ALTERNATION:   return IsNullable(n.left) || IsNullable(n.right);
+    case NODETYPE_REPETITION:    return n.minCount == 0 || IsNullable(n.left);
+    }
+    return false;
+  }
+}
+
+#endif
+#endif
@@ -0,0 +1,157 @@
+#ifndef __QPARSER_STATICLEXER_H__
+#define __QPARSER_STATICLEXER_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    STATICLEXER.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A lexer specialized at compile time for a fixed set of tokens. The
+      tokens are given as constexpr data by a definition class:
+
+        struct CalculatorTokens
+        {
+          static constexpr StaticToken tokens[] =
+          {
+            StaticToken::String(Lexer::TOKENTYPE_NIL, "space", " "),
+            StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "plus", "+"),
+            StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "let", "let")
+          };
+        };
+
+        StaticLexer<CalculatorTokens>::LexicalAnalysis(input, inputLength, tokenMatches);
+
+      The lex stream is identical to that of a Lexer defined with the same
+      tokens (see DefineTokens) and built in the same order.
+
+    IMPLEMENTATION:
+      + The trie of all raw tokens, nil tokens and lex symbols is built by
+        constexpr functions into read-only tables, so nothing is constructed
+        at runtime. Each state of the trie is matched by its own template
+        instantiation, in which the depth of the state, the tokens it
+        accepts and the characters of its transitions are constants. The
+        transitions are a chain of comparisons against constant characters,
+        which the compiler lowers into a switch.
+      + The token matched at a position is the one with the highest
+        precedence (its type, then the order of definition) of all tokens
+        that match a prefix of the input there, which is also what the
+        automaton of Lexer selects.
+      + Lex words are compared against each keyword of the same length
+        (with the keyword and its length as constants).
+      + Token ids are assigned in the order of definition starting at
+        TOKEN_TERMINAL_FIRST, as TokenRegistry assigns them to the first
+        terminals generated (see RegisterTokens).
+      + Tokens must be defined grouped by type in the order in which the
+        types are built (raw tokens, nil tokens, lex symbols and lex words)
+        and their names must be unique (this is checked at compile time).
+        Regular expression tokens are not supported.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  // A token definition of a static lexer
+  struct StaticToken
+  {
+    Lexer::TokenType type;
+    const_cstring name;
+    const_cstring value;                    // The value of the token (or the opening boundary of a bounded token)
+    const_cstring closingValue;             // The closing boundary of a bounded token (null if the token is not bounded)
+    OSIX::PARSER_BOUNDED_LINETYPE lineType; // Whether a bounded token may span multiple lines
+
+    // Construction
+    static constexpr StaticToken String(Lexer::TokenType type, const_cstring name, const_cstring value) { return StaticToken { type, name, value, null, OSIX::SINGLE_LINE }; }
+    static constexpr StaticToken Bounded(Lexer::TokenType type, const_cstring name, const_cstring leftBoundingValue, const_cstring rightBoundingValue, OSIX::PARSER_BOUNDED_LINETYPE lineType) { return StaticToken { type, name, leftBoundingValue, rightBoundingValue, lineType }; }
+  };
+
+  // Compile time analysis of an array of token definitions
+  struct StaticTokenSet
+  {
+    static constexpr uint StringLength(const_cstring value);
+    static constexpr bool StringEqual(const_cstring value1, const_cstring value2);
+
+    // Count the states of the trie of all symbol tokens (including the root)
+    static constexpr uint CountStates(const StaticToken* tokens, uint nTokens);
+
+    // Validate the token definitions
+    static constexpr bool IsTypeOrdered(const StaticToken* tokens, uint nTokens);
+    static constexpr bool IsNameUnique(const StaticToken* tokens, uint nTokens);
+    static constexpr bool IsValueValid(const StaticToken* tokens, uint nTokens);
+  };
+
+  // The tables of a static lexer (built at compile time)
+  template<uint N_TOKENS, uint N_STATES> struct StaticLexerTables
+  {
+    // The trie of all raw tokens, nil tokens and lex symbols (state 0 is the root)
+    uint  nStates;
+    uint8 characters[N_STATES];    // The character on the transition into each state
+    uint  depths[N_STATES];        // The number of characters matched in each state
+    uint  childBegin[N_STATES];    // The range of the children of each state in children
+    uint  childEnd[N_STATES];
+    uint  children[N_STATES];
+    uint  acceptBegin[N_STATES];   // The range of the tokens accepted in each state in accepts (in order of precedence)
+    uint  acceptEnd[N_STATES];
+    uint  accepts[N_TOKENS];
+    uint  bestReachable[N_STATES]; // The token with the highest precedence accepted in any state following each state
+    bool  startCharacters[256];    // The characters on which a symbol token can start
+
+    // The lex words (in order of definition)
+    uint  nWords;
+    uint  words[N_TOKENS];
+
+    // Build the tables
+    static constexpr StaticLexerTables Build(const StaticToken* tokens);
+  };
+
+  template<typename Definition> class StaticLexer
+  {
+  public:
+    static const uint TOKEN_NONE = ~0u;
+
+    // Get the token id of a token by name
+    static constexpr ParseToken GetToken(const_cstring tokenName);
+
+    // Generate the terminals of all tokens in a token registry (which may not contain any terminals yet)
+    static INLINE void RegisterTokens(TokenRegistry& tokenRegistry);
+
+    // Add all tokens to a runtime lexer and build it (the token registry of the lexer may not contain any terminals yet)
+    static INLINE void DefineTokens(Lexer& lexer);
+
+    // Perform lexical analysis on an input string, replacing the contents of the match buffer by the lex stream
+    static INLINE void LexicalAnalysis(const_cstring input, ParseOffset inputLength, MatchBuffer& tokenMatches);
+
+  protected:
+    static constexpr uint N_TOKENS = uint(sizeof(Definition::tokens) / sizeof(StaticToken));
+
+    static_assert(N_TOKENS > 0, "A static lexer must define at least one token");
+    static_assert(StaticTokenSet::IsTypeOrdered(Definition::tokens, N_TOKENS), "Static lexer tokens must be grouped by type in the order raw, nil, lex symbol, lex word");
+    static_assert(StaticTokenSet::IsNameUnique(Definition::tokens, N_TOKENS), "Static lexer token names must be unique");
+    static_assert(StaticTokenSet::IsValueValid(Definition::tokens, N_TOKENS), "Static lexer token values may not be empty and lex words may not be bounded");
+
+    typedef StaticLexerTables<N_TOKENS, StaticTokenSet::CountStates(Definition::tokens, N_TOKENS)> Tables;
+    static constexpr Tables tables = Tables::Build(Definition::tokens);
+
+    // Match the symbol tokens that continue from a state of the trie (keeping the token with the highest precedence)
+    template<uint STATE> static INLINE void MatchState(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength);
+    template<uint STATE, size_t... I> static FORCE_INLINE bool MatchAccepts(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength, std::index_sequence<I...>);
+    template<uint STATE, size_t... I> static FORCE_INLINE void MatchTransition(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength, std::index_sequence<I...>);
+
+    // Match a token accepted in a state of the trie (bounded tokens must still find their closing boundary)
+    template<uint STATE, uint TOKEN> static FORCE_INLINE bool MatchToken(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength);
+    template<uint TOKEN> static INLINE bool MatchBoundingToken(const_cstring inputPosition, ParseOffset inputLength, ParseLength& matchLength);
+
+    // Classify a lex word as a keyword, a literal or an identifier
+    static INLINE ParseToken ParseWordToken(const_cstring inputPosition, ParseLength length);
+    template<size_t... I> static FORCE_INLINE bool MatchWords(const_cstring inputPosition, ParseLength length, ParseToken& token, std::index_sequence<I...>);
+    template<uint TOKEN> static FORCE_INLINE bool MatchWord(const_cstring inputPosition, ParseLength length, ParseToken& token);
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "staticlexer.inl"
+
+#endif
@@ -0,0 +1,339 @@
+#ifdef  __QPARSER_STATICLEXER_H__
+#ifndef __QPARSER_STATICLEXER_INL__
+#define __QPARSER_STATICLEXER_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    STATICLEXER.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  constexpr uint StaticTokenSet::StringLength(const_cstring value)
+  {
+    uint length = 0;
+    while(value[length] != '\0')
+      ++length;
+    return length;
+  }
+
+  constexpr bool StaticTokenSet::StringEqual(const_cstring value1, const_cstring value2)
+  {
+    uint c = 0;
+    while(value1[c] != '\0' && value1[c] == value2[c])
+      ++c;
+    return value1[c] == value2[c];
+  }
+
+  constexpr uint StaticTokenSet::CountStates(const StaticToken* tokens, uint nTokens)
+  {
+    // (Every character of a symbol token adds at most one state to the trie)
+    uint nStates = 1;
+    for(uint cToken = 0; cToken < nTokens; ++cToken)
+      if(tokens[cToken].type != Lexer::TOKENTYPE_LEX_WORD)
+        nStates += StringLength(tokens[cToken].value);
+    return nStates;
+  }
+
+  constexpr bool StaticTokenSet::IsTypeOrdered(const StaticToken* tokens, uint nTokens)
+  {
+    for(uint cToken = 1; cToken < nTokens; ++cToken)
+      if(tokens[cToken].type < tokens[cToken - 1].type)
+        return false;
+    return true;
+  }
+
+  constexpr bool StaticTokenSet::IsNameUnique(const StaticToken* tokens, uint nTokens)
+  {
+    for(uint cToken = 0; cToken < nTokens; ++cToken)
+      for(uint cOther = 0; cOther < cToken; ++cOther)
+        if(StringEqual(tokens[cToken].name, tokens[cOther].name))
+          return false;
+    return true;
+  }
+
+  constexpr bool StaticTokenSet::IsValueValid(const StaticToken* tokens, uint nTokens)
+  {
+    for(uint cToken = 0; cToken < nTokens; ++cToken)
+    {
+      const StaticToken& token = tokens[cToken];
+      if(token.value[0] == '\0' || (token.type == Lexer::TOKENTYPE_LEX_WORD && token.closingValue != null))
+        return false;
+    }
+    return true;
+  }
+
+  template<uint N_TOKENS, uint N_STATES> constexpr StaticLexerTables<N_TOKENS, N_STATES> StaticLexerTables<N_TOKENS, N_STATES>::Build(const StaticToken* tokens)
+  {
+    StaticLexerTables tables {};
+    uint parents[N_STATES] = {};
+    uint tokenStates[N_TOKENS] = {};
+
+    // Insert the symbol tokens into the trie
+    tables.nStates = 1;
+    for(uint cToken = 0; cToken < N_TOKENS; ++cToken)
+    {
+      const StaticToken& token = tokens[cToken];
+      if(token.type == Lexer::TOKENTYPE_LEX_WORD)
+      {
+        tables.words[tables.nWords++] = cToken;
+        continue;
+      }
+
+      uint state = 0;
+      for(uint c = 0; token.value[c] != '\0'; ++c)
+      {
+        uint next = 0;
+        for(uint cState = 1; cState < tables.nStates && next == 0; ++cState)
+          if(parents[cState] == state && tables.characters[cState] == uint8(token.value[c]))
+            next = cState;
+
+        if(next == 0)
+        {
+          next = tables.nStates++;
+          parents[next] = state;
+          tables.characters[next] = uint8(token.value[c]);
+          tables.depths[next] = c + 1;
+        }
+        state = next;
+      }
+      tokenStates[cToken] = state;
+    }
+
+    // Group the children and the accepted tokens of each state
+    uint nChildren = 0;
+    uint nAccepts = 0;
+    for(uint cState = 0; cState < tables.nStates; ++cState)
+    {
+      tables.childBegin[cState] = nChildren;
+      for(uint cChild = 1; cChild < tables.nStates; ++cChild)
+        if(parents[cChild] == cState)
+          tables.children[nChildren++] = cChild;
+      tables.childEnd[cState] = nChildren;
+
+      tables.acceptBegin[cState] = nAccepts;
+      for(uint cToken = 0; cToken < N_TOKENS; ++cToken)
+        if(tokens[cToken].type != Lexer::TOKENTYPE_LEX_WORD && tokenStates[cToken] == cState)
+          tables.accepts[nAccepts++] = cToken;
+      tables.acceptEnd[cState] = nAccepts;
+    }
+
+    // Find the best token reachable from each state (children are always created after their parents)
+    for(uint cState = 0; cState < tables.nStates; ++cState)
+      tables.bestReachable[cState] = ~0u;
+    for(uint cState = tables.nStates - 1; cState > 0; --cState)
+    {
+      uint best = tables.bestReachable[cState];
+      if(tables.acceptBegin[cState] != tables.acceptEnd[cState] && tables.accepts[tables.acceptBegin[cState]] < best)
+        best = tables.accepts[tables.acceptBegin[cState]];
+      if(best < tables.bestReachable[parents[cState]])
+        tables.bestReachable[parents[cState]] = best;
+    }
+
+    for(uint cChild = tables.childBegin[0]; cChild < tables.childEnd[0]; ++cChild)
+      tables.startCharacters[tables.characters[tables.children[cChild]]] = true;
+    return tables;
+  }
+
+  template<typename Definition> const uint StaticLexer<Definition>::TOKEN_NONE;
+
+  template<typename Definition> constexpr ParseToken StaticLexer<Definition>::GetToken(const_cstring tokenName)
+  {
+    for(uint cToken = 0; cToken < N_TOKENS; ++cToken)
+      if(StaticTokenSet::StringEqual(Definition::tokens[cToken].name, tokenName))
+        return TOKEN_TERMINAL_FIRST + cToken;
+    return TOKEN_SPECIAL_EOF; // (no token by this name)
+  }
+
+  template<typename Definition> INLINE void StaticLexer<Definition>::RegisterTokens(TokenRegistry& tokenRegistry)
+  {
+    for(uint cToken = 0; cToken < N_TOKENS; ++cToken)
+    {
+      const ParseToken token = tokenRegistry.GenerateTerminal(Definition::tokens[cToken].name);
+      OSI_ASSERT(token == TOKEN_TERMINAL_FIRST + cToken);
+    }
+  }
+
+  template<typename Definition> INLINE void StaticLexer<Definition>::DefineTokens(Lexer& lexer)
+  {
+    for(uint cToken = 0; cToken < N_TOKENS; ++cToken)
+    {
+      const StaticToken& definition = Definition::tokens[cToken];
+      const ParseToken token = (definition.closingValue != null)?
+          lexer.BoundedToken(definition.name, definition.value, definition.closingValue, definition.lineType)
+        : lexer.StringToken(definition.name, definition.value);
+      OSI_ASSERT(token == TOKEN_TERMINAL_FIRST + cToken);
+
+      // Build each type once all of its tokens are defined
+      if(cToken + 1 == N_TOKENS || Definition::tokens[cToken + 1].type != definition.type)
+        lexer.Build(definition.type);
+    }
+  }
+
+  template<typename Definition> INLINE void StaticLexer<Definition>::LexicalAnalysis(const_cstring input, ParseOffset inputLength, MatchBuffer& tokenMatches)
+  {
+    const_cstring const inputEnd = &input[inputLength];
+    const_cstring parsePosition        = input;
+    const_cstring lexWordStartPosition = input;
+
+    tokenMatches.Clear();
+    while(parsePosition < inputEnd)
+    {
+      // Skip characters on which no symbol token can start (these characters are part of a lex word)
+      if(!tables.startCharacters[uint8(*parsePosition)])
+      {
+        ++parsePosition;
+        continue;
+      }
+
+      // Match raw token, nil token or lex symbol token
+      uint token = TOKEN_NONE;
+      ParseLength length = 0;
+      MatchState<0>(parsePosition, (ParseOffset)(inputEnd - parsePosition), token, length);
+      if(token == TOKEN_NONE)
+      {
+        // Ignore unparsed character (current character will be evaluated as part of a lex word later)
+        ++parsePosition;
+        continue;
+      }
+
+      // Parse all unparsed characters into lex word
+      if(lexWordStartPosition != parsePosition)
+      {
+        const ParseLength wordLength = (ParseLength)(parsePosition - lexWordStartPosition);
+        tokenMatches.PushBack(ParseMatch((ParseOffset)(lexWordStartPosition - input), wordLength, ParseWordToken(lexWordStartPosition, wordLength)));
+      }
+
+      // Add token to token matches (ignoring nil tokens)
+      if(Definition::tokens[token].type != Lexer::TOKENTYPE_NIL)
+        tokenMatches.PushBack(ParseMatch((ParseOffset)(parsePosition - input), length, TOKEN_TERMINAL_FIRST + token));
+
+      parsePosition += length;
+      lexWordStartPosition = parsePosition;
+    }
+
+    // Parse the final unparsed characters into lex word
+    if(lexWordStartPosition != parsePosition)
+    {
+      const ParseLength wordLength = (ParseLength)(parsePosition - lexWordStartPosition);
+      tokenMatches.PushBack(ParseMatch((ParseOffset)(lexWordStartPosition - input), wordLength, ParseWordToken(lexWordStartPosition, wordLength)));
+    }
+  }
+
+  template<typename Definition> template<uint STATE> INLINE void StaticLexer<Definition>::MatchState(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength)
+  {
+    // Try the tokens accepted in this state that take precedence over the best match so far
+    MatchAccepts<STATE>(inputPosition, inputLength, bestToken, bestLength, std::make_index_sequence<tables.acceptEnd[STATE] - tables.acceptBegin[STATE]>());
+
+    // Continue while a token with a higher precedence than the best match can be reached
+    if constexpr(tables.childBegin[STATE] != tables.childEnd[STATE])
+    {
+      if(tables.bestReachable[STATE] > bestToken || tables.depths[STATE] == inputLength)
+        return;
+      MatchTransition<STATE>(inputPosition, inputLength, bestToken, bestLength, std::make_index_sequence<tables.childEnd[STATE] - tables.childBegin[STATE]>());
+    }
+  }
+
+  template<typename Definition> template<uint STATE, size_t... I> FORCE_INLINE bool StaticLexer<Definition>::MatchAccepts(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength, std::index_sequence<I...>)
+  {
+    // (The accepted tokens are in order of precedence, so the first one that matches is taken)
+    return (MatchToken<STATE, tables.accepts[tables.acceptBegin[STATE] + I]>(inputPosition, inputLength, bestToken, bestLength) || ...);
+  }
+
+  template<typename Definition> template<uint STATE, size_t... I> FORCE_INLINE void StaticLexer<Definition>::MatchTransition(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength, std::index_sequence<I...>)
+  {
+    const uint8 character = uint8(inputPosition[tables.depths[STATE]]);
+    (void)((character == tables.characters[tables.children[tables.childBegin[STATE] + I]]
+        && (MatchState<tables.children[tables.childBegin[STATE] + I]>(inputPosition, inputLength, bestToken, bestLength), true)) || ...);
+  }
+
+  template<typename Definition> template<uint STATE, uint TOKEN> FORCE_INLINE bool StaticLexer<Definition>::MatchToken(const_cstring inputPosition, ParseOffset inputLength, uint& bestToken, ParseLength& bestLength)
+  {
+    if(TOKEN > bestToken)
+      return false;
+
+    ParseLength matchLength = ParseLength(tables.depths[STATE]);
+    if constexpr(Definition::tokens[TOKEN].closingValue != null)
+    {
+      if(!MatchBoundingToken<TOKEN>(inputPosition, inputLength, matchLength))
+        return false;
+    }
+
+    bestToken = TOKEN;
+    bestLength = matchLength;
+    return true;
+  }
+
+  template<typename Definition> template<uint TOKEN> INLINE bool StaticLexer<Definition>::MatchBoundingToken(const_cstring inputPosition, ParseOffset inputLength, ParseLength& matchLength)
+  {
+    constexpr const StaticToken& token = Definition::tokens[TOKEN];
+    constexpr uint openingLength = StaticTokenSet::StringLength(token.value);
+    constexpr uint closingLength = StaticTokenSet::StringLength(token.closingValue);
+    constexpr bool singleLine = (token.lineType == OSIX::SINGLE_LINE);
+    const_cstring const inputEnd = inputPosition + inputLength;
+
+    // Find end-of-line (or end-of-input) if the closing boundary is empty
+    if constexpr(closingLength == 0 || token.closingValue[0] == PARSER_TOKEN_VALUE_EOF[0])
+    {
+      matchLength = singleLine? (ParseLength)(CharScan::FindEither(inputPosition + openingLength, inputEnd, '\n', '\n') - inputPosition) : (ParseLength)inputLength;
+      return true;
+    }
+    else
+    {
+      // Test whether remaining characters can contain the closing boundary
+      if(openingLength + closingLength > inputLength)
+        return false;
+
+      // Skip ahead to each possible start of the closing boundary (or to the end of the line for single-line tokens)
+      const_cstring const searchEnd = inputEnd - closingLength + 1;
+      const char closingCharacter = token.closingValue[0];
+      const char lineCharacter = singleLine? '\n' : closingCharacter;
+      for(const_cstring position = inputPosition + openingLength; position < searchEnd; ++position)
+      {
+        position = CharScan::FindEither(position, searchEnd, closingCharacter, lineCharacter);
+        if(position == searchEnd)
+          break;
+
+        if(memcmp(position, token.closingValue, closingLength) == 0)
+        {
+          matchLength = (ParseLength)(position - inputPosition) + closingLength;
+          return true;
+        }
+
+        if(singleLine && *position == '\n')
+          return false; // (single-line mismatch)
+      }
+      return false;
+    }
+  }
+
+  template<typename Definition> INLINE ParseToken StaticLexer<Definition>::ParseWordToken(const_cstring inputPosition, ParseLength length)
+  {
+    ParseToken token = TOKEN_TERMINAL_IDENTIFIER;
+    if(MatchWords(inputPosition, length, token, std::make_index_sequence<tables.nWords>()))
+      return token;
+
+    // Test whether word is a numeric constant or an identifier
+    return (*inputPosition >= '0' && *inputPosition <= '9')? TOKEN_TERMINAL_LITERAL : TOKEN_TERMINAL_IDENTIFIER;
+  }
+
+  template<typename Definition> template<size_t... I> FORCE_INLINE bool StaticLexer<Definition>::MatchWords(const_cstring inputPosition, ParseLength length, ParseToken& token, std::index_sequence<I...>)
+  {
+    return (MatchWord<tables.words[I]>(inputPosition, length, token) || ...);
+  }
+
+  template<typename Definition> template<uint TOKEN> FORCE_INLINE bool StaticLexer<Definition>::MatchWord(const_cstring inputPosition, ParseLength length, ParseToken& token)
+  {
+    constexpr uint wordLength = StaticTokenSet::StringLength(Definition::tokens[TOKEN].value);
+    if(length != wordLength || memcmp(inputPosition, Definition::tokens[TOKEN].value, wordLength) != 0)
+      return false;
+
+    token = TOKEN_TERMINAL_FIRST + TOKEN;
+    return true;
+  }
+}
+
+#endif
+#endif
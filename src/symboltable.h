@@ -0,0 +1,80 @@
+#ifndef __QPARSER_SYMBOLTABLE_H__
+#define __QPARSER_SYMBOLTABLE_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    SYMBOLTABLE.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A table of interned identifiers. Every distinct identifier is assigned
+      a dense symbol id (in the order in which the identifiers are first
+      interned), so that names can be compared as integers.
+
+    IMPLEMENTATION:
+      + An open addressing hash table (with linear probing) maps the text of
+        an identifier to its symbol. The hash consumes 8 characters at a time.
+      + The text of all symbols is concatenated into a single array (each
+        followed by a '\0' character).
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class SymbolTable
+  {
+  public:
+    // Dense symbol ids
+    typedef uint32 SymbolId;
+    static const SymbolId SYMBOL_NONE = ~SymbolId(0);
+
+    // Construction
+    INLINE SymbolTable();
+
+    // Remove all symbols
+    INLINE void Clear();
+
+    // Get the symbol of an identifier, adding it to the table if it does not exist yet
+    INLINE SymbolId Intern(const_cstring text, uint length);
+
+    // Get the symbol of an identifier (returns SYMBOL_NONE if the identifier has not been interned)
+    INLINE SymbolId Find(const_cstring text, uint length) const;
+
+    //// Accessors
+    INLINE const_cstring GetText(SymbolId symbol) const { return &characters[symbols[symbol].offset]; }
+    INLINE uint GetLength(SymbolId symbol) const { return symbols[symbol].length; }
+    INLINE uint GetSymbolCount() const { return (uint)symbols.size(); }
+
+  protected:
+    // An interned identifier
+    struct Symbol
+    {
+      uint32 offset;  // Offset of the identifier's characters
+      uint32 length;  // Length of the identifier
+      uint32 hash;    // Hash of the identifier
+    };
+
+    static const uint MIN_SLOT_COUNT = 64;  // The initial size of the hash table
+
+    std::vector<Symbol> symbols;            // All symbols (indexed by symbol id)
+    std::vector<char> characters;           // Concatenation of all identifiers
+    std::vector<SymbolId> slots;            // The hash table (a power of two in size, SYMBOL_NONE marks an empty slot)
+
+    // Hash the characters of an identifier
+    static FORCE_INLINE uint32 Hash(const_cstring text, uint length);
+
+    // Find the slot of an identifier (either the slot holding its symbol or the empty slot where it belongs)
+    FORCE_INLINE uint FindSlot(const_cstring text, uint length, uint32 hash) const;
+
+    // Double the size of the hash table
+    INLINE void Grow();
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "symboltable.inl"
+
+#endif
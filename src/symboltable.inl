@@ -0,0 +1,113 @@
+#ifdef  __QPARSER_SYMBOLTABLE_H__
+#ifndef __QPARSER_SYMBOLTABLE_INL__
+#define __QPARSER_SYMBOLTABLE_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    SYMBOLTABLE.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  const SymbolTable::SymbolId SymbolTable::SYMBOL_NONE;
+  const uint SymbolTable::MIN_SLOT_COUNT;
+
+  INLINE SymbolTable::SymbolTable()
+  {
+    Clear();
+  }
+
+  INLINE void SymbolTable::Clear()
+  {
+    symbols.clear();
+    characters.clear();
+    slots.assign(MIN_SLOT_COUNT, SYMBOL_NONE);
+  }
+
+  INLINE SymbolTable::SymbolId SymbolTable::Intern(const_cstring text, uint length)
+  {
+    const uint32 hash = Hash(text, length);
+    const uint slot = FindSlot(text, length, hash);
+    if(slots[slot] != SYMBOL_NONE)
+      return slots[slot];
+
+    // Add a new symbol
+    Symbol symbol;
+    symbol.offset = (uint32)characters.size();
+    symbol.length = length;
+    symbol.hash = hash;
+    characters.insert(characters.end(), text, text + length);
+    characters.push_back('\0');
+
+    const SymbolId symbolId = (SymbolId)symbols.size();
+    symbols.push_back(symbol);
+    slots[slot] = symbolId;
+
+    // Keep the table at most half full
+    if(symbols.size() * 2 > slots.size())
+      Grow();
+    return symbolId;
+  }
+
+  INLINE SymbolTable::SymbolId SymbolTable::Find(const_cstring text, uint length) const
+  {
+    return slots[FindSlot(text, length, Hash(text, length))];
+  }
+
+  FORCE_INLINE uint32 SymbolTable::Hash(const_cstring text, uint length)
+  {
+    uint64 hash = uint64(length) * 0x9e3779b97f4a7c15ULL;
+
+    // Mix in 8 characters at a time
+    for(; length >= 8; length -= 8, text += 8)
+    {
+      uint64 characters;
+      memcpy(&characters, text, 8);
+      hash = (hash ^ characters) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 32;
+    }
+
+    // Mix in the remaining characters
+    uint64 characters = 0;
+    for(uint c = 0; c < length; ++c)
+      characters = (characters << 8) | uint8(text[c]);
+    hash = (hash ^ characters) * 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 29;
+    return uint32(hash);
+  }
+
+  FORCE_INLINE uint SymbolTable::FindSlot(const_cstring text, uint length, uint32 hash) const
+  {
+    const uint mask = (uint)slots.size() - 1;
+    for(uint slot = hash & mask;; slot = (slot + 1) & mask)
+    {
+      const SymbolId symbolId = slots[slot];
+      if(symbolId == SYMBOL_NONE)
+        return slot;
+
+      const Symbol& symbol = symbols[symbolId];
+      if(symbol.hash == hash && symbol.length == length && memcmp(&characters[symbol.offset], text, length) == 0)
+        return slot;
+    }
+  }
+
+  INLINE void SymbolTable::Grow()
+  {
+    slots.assign(slots.size() * 2, SYMBOL_NONE);
+
+    // Reinsert all symbols (they are all distinct, so only an empty slot needs to be found for each)
+    const uint mask = (uint)slots.size() - 1;
+    for(SymbolId symbolId = 0; symbolId < symbols.size(); ++symbolId)
+    {
+      uint slot = symbols[symbolId].hash & mask;
+      while(slots[slot] != SYMBOL_NONE)
+        slot = (slot + 1) & mask;
+      slots[slot] = symbolId;
+    }
+  }
+}
+
+#endif
+#endif
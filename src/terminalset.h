@@ -0,0 +1,57 @@
+#ifndef __QPARSER_TERMINALSET_H__
+#define __QPARSER_TERMINALSET_H__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    TERMINALSET.H
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    DESCRIPTION:
+      A set of terminal tokens.
+
+    IMPLEMENTATION:
+      + Terminals are assigned sequentially, so the set is stored as a dense
+        bitset indexed by the terminal's number (the token without its
+        TOKEN_FLAG_SHIFT flag). The bitset grows as terminals are added.
+*/
+
+/*                                  CLASSES                                 */
+namespace QParser
+{
+  class TerminalSet
+  {
+  public:
+    // Construction
+    INLINE TerminalSet() {}
+
+    // Remove all terminals
+    INLINE void Clear() { words.clear(); }
+
+    // Add a terminal to the set
+    INLINE void Add(ParseToken terminal);
+
+    // Add all terminals of another set to the set (returns true if the set changed)
+    INLINE bool Union(const TerminalSet& terminals);
+
+    // Test whether the set contains a terminal
+    FORCE_INLINE bool Contains(ParseToken terminal) const
+    {
+      const ParseToken index = terminal & ~TOKEN_FLAG_SHIFT;
+      return index / 64 < words.size() && (words[index / 64] & (uint64(1) << (index % 64))) != 0;
+    }
+
+    // Test whether the set contains no terminals
+    INLINE bool IsEmpty() const;
+
+  protected:
+    std::vector<uint64> words; // The bits of the set (bit n holds terminal TOKEN_FLAG_SHIFT | n)
+  };
+}
+
+/*                                   INCLUDES                               */
+#include "terminalset.inl"
+
+#endif
@@ -0,0 +1,47 @@
+#ifdef  __QPARSER_TERMINALSET_H__
+#ifndef __QPARSER_TERMINALSET_INL__
+#define __QPARSER_TERMINALSET_INL__
+//////////////////////////////////////////////////////////////////////////////
+//
+//    TERMINALSET.INL
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+namespace QParser
+{
+  INLINE void TerminalSet::Add(ParseToken terminal)
+  {
+    OSI_ASSERT(TokenRegistry::IsTerminal(terminal) && terminal != TOKEN_SPECIAL_EOF);
+    const ParseToken index = terminal & ~TOKEN_FLAG_SHIFT;
+    if(index / 64 >= words.size())
+      words.resize(index / 64 + 1, 0);
+    words[index / 64] |= uint64(1) << (index % 64);
+  }
+
+  INLINE bool TerminalSet::Union(const TerminalSet& terminals)
+  {
+    if(terminals.words.size() > words.size())
+      words.resize(terminals.words.size(), 0);
+
+    uint64 changed = 0;
+    for(uint c = 0; c < terminals.words.size(); ++c)
+    {
+      changed |= terminals.words[c] & ~words[c];
+      words[c] |= terminals.words[c];
+    }
+    return changed != 0;
+  }
+
+  INLINE bool TerminalSet::IsEmpty() const
+  {
+    for(uint c = 0; c < words.size(); ++c)
+      if(words[c] != 0)
+        return false;
+    return true;
+  }
+}
+
+#endif
+#endif
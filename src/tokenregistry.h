@@ -11,21 +11,49 @@
 /*
     DESCRIPTION:
       Create, manage and store parse tokens
+
+    IMPLEMENTATION:
+      + Terminals and nonterminals are assigned sequentially, so their names
+        are kept in dense arrays indexed by token - TOKEN_TERMINAL_FIRST and
+        token - TOKEN_NONTERMINAL_FIRST.
+      + Every name is stored once (null terminated) in an arena of large
+        blocks of characters. The blocks are never moved or freed before the
+        registry, so the names returned by GetTokenName remain valid for as
+        long as the registry exists. A temporary token keeps its name when
+        it is resolved to a nonterminal.
+      + Names are mapped to tokens by two open addressing hash tables (with
+        linear probing) of names in the arena: one for terminals and one for
+        nonterminals and temporary tokens.
+      + Every operation taking a name has an overload taking the length of
+        the name, which need not be null terminated. Lookups compare the
+        characters in place and never allocate.
+      + A registry can be built against a snapshot of another registry (see
+        SetBase and FrozenTokenRegistry). The tokens of the snapshot are
+        found in the snapshot instead of being stored again, and new tokens
+        are assigned after them, so that many parsers of the same language
+        share a single copy of its names.
 */
 namespace QParser
 {
+  class FrozenTokenRegistry;
+
   class TokenRegistry
   {
+    friend class FrozenTokenRegistry;
+
   public:
-    // Container types
-    //typedef std::unordered_map<const std::string, ParseToken> TokenValues; // Map names to token values
-    typedef std::unordered_map<std::string, ParseToken> TokenValues; // Map names to token values
-    typedef std::map<ParseToken, std::string> TokenNames;                  // Map token values to their corresponding names
-    
     // Construction
     INLINE TokenRegistry();
     INLINE TokenRegistry(TokenRegistry&) = delete;
     
+    // Build the registry against a snapshot of another registry: The tokens of the snapshot keep their values and names (they are
+    // looked up in the snapshot rather than stored again) and new tokens are assigned after them. The registry must still be empty.
+    INLINE void SetBase(const std::shared_ptr<const FrozenTokenRegistry>& baseRegistry);
+    INLINE const std::shared_ptr<const FrozenTokenRegistry>& GetBase() const { return baseRegistry; }
+
+    // Test whether no tokens were registered (beyond the tokens of the base snapshot)
+    INLINE bool IsEmpty() const;
+
     // Look up the next available terminal token
     INLINE ParseToken GetNextAvailableTerminal() const;
 
@@ -37,31 +65,43 @@ namespace QParser
     
     // Add a new terminal token to the registry
     INLINE ParseToken GenerateTerminal(const_cstring terminalName);
+    INLINE ParseToken GenerateTerminal(const_cstring terminalName, uint nameLength);
 
     // Add a new non-terminal token to the registry
     INLINE ParseToken GenerateNonterminal(const_cstring nonterminalName);
+    INLINE ParseToken GenerateNonterminal(const_cstring nonterminalName, uint nameLength);
     
     // Add a new temporary token to the registry
     INLINE ParseToken GenerateTemporaryToken(const_cstring nonterminalName);
+    INLINE ParseToken GenerateTemporaryToken(const_cstring nonterminalName, uint nameLength);
     
     // Resolve a temporary token with a nonterminal token and replace the references to it in the token registry
     INLINE ParseToken ResolveTemporaryToken(const_cstring nonterminalName);
+    INLINE ParseToken ResolveTemporaryToken(const_cstring nonterminalName, uint nameLength);
     
     // Get a token by the name used to identify it
     INLINE ParseToken GetToken(const_cstring tokenName) const;
+    INLINE ParseToken GetToken(const_cstring tokenName, uint nameLength) const;
     
     // Get a terminal token by the name used to identify it
     INLINE ParseToken GetTerminal(const_cstring terminalName) const;
+    INLINE ParseToken GetTerminal(const_cstring terminalName, uint nameLength) const;
     
     // Get a non-terminal token by the name used to identify it
     INLINE ParseToken GetNonterminal(const_cstring nonterminalName) const;
+    INLINE ParseToken GetNonterminal(const_cstring nonterminalName, uint nameLength) const;
             
     // Get the name corresponding to a specific token by token value
-    INLINE const std::string& GetTokenName(ParseToken token) const;
+    // (the name remains valid for the lifetime of the registry)
+    INLINE const_cstring GetTokenName(ParseToken token) const;
+
+    // Get the name of a special token (or of an unknown token)
+    static INLINE const_cstring GetSpecialTokenName(ParseToken token);
     
     // Get an existing nonterminal token by the name used to identify it 
     // or otherwise generate a temporary token corresponding to the name.
     INLINE ParseToken FindOrGenerateTemporaryNonterminal(const_cstring tokenName);
+    INLINE ParseToken FindOrGenerateTemporaryNonterminal(const_cstring tokenName, uint nameLength);
     
     // Test whether a token is a terminal token (as opposed to a non-terminal)
     static INLINE bool IsTerminal(ParseToken token);
@@ -70,7 +110,7 @@ namespace QParser
     static INLINE bool IsNonterminal(ParseToken token);
     
     // Test whether a token is a temporary token
-    INLINE bool IsTemporaryToken(ParseToken token);
+    INLINE bool IsTemporaryToken(ParseToken token) const;
     
     // Check whether a token is valid (this is mostly for debugging purposes)
     INLINE bool IsTokenValid(ParseToken token) const;
@@ -81,15 +121,71 @@ namespace QParser
     // Check whether a non-terminal token is valid (this is mostly for debugging purposes)
     INLINE bool IsNonterminalValid(ParseToken nonterminal) const;
     
-  protected:    
+    // Take an immutable snapshot of the registry which may be shared by any number of parsers and threads (see FrozenTokenRegistry)
+    // (The base snapshot itself is returned if no tokens were registered beyond it)
+    INLINE std::shared_ptr<const FrozenTokenRegistry> Freeze() const;
+
+  protected:
+    static const uint NAME_BLOCK_LENGTH = 16384; // The number of characters in a block of the arena (longer names get a block of their own)
+
+    // A slot in a name table
+    struct NameSlot
+    {
+      uint32 hash;        // The hash of the name
+      uint32 length;      // Length of the name
+      const_cstring name; // The name in the arena (null if the slot is empty)
+      ParseToken token;   // The token identified by the name
+    };
+
+    // An open addressing hash table mapping names to tokens
+    struct NameTable
+    {
+      std::vector<NameSlot> slots;  // The table (a power of two in size)
+      uint32 slotMask;              // Mask used to find a slot from a hash
+      uint32 size;                  // The number of occupied slots
+    };
+
     ParseToken nextTerminalToken;     // The next available terminal token
     ParseToken nextNonterminalToken;  // The next available nonterminal token
     ParseToken nextTemporaryToken;    // The next available temporary (dummy) token
-    
-    TokenNames terminalNames;       // Map of all terminal names corresponding to their token values
-    TokenNames nonterminalNames;    // Map of all non-terminal names corresponding to their token values
-    TokenValues terminalTokens;     // Map of all terminal tokens corresponding to their names
-    TokenValues nonterminalTokens;  // Map of all non-terminal tokens corresponding to their names
+
+    std::shared_ptr<const FrozenTokenRegistry> baseRegistry; // The snapshot that the registry is built against (null if there is none)
+    ParseToken baseTerminalToken;     // The first terminal token that is not in the base snapshot
+    ParseToken baseNonterminalToken;  // The first non-terminal token that is not in the base snapshot
+
+    std::vector< std::unique_ptr<char[]> > nameBlocks; // The blocks of the arena holding all token names (each followed by a null character)
+    char* nameBlockEnd;                   // The first free character of the last block
+    uint nameBlockRemaining;              // The number of free characters in the last block
+    uint namesLength;                     // The number of characters stored in the arena
+    std::vector<const_cstring> terminalNames;    // The terminal names in the arena (indexed by token - baseTerminalToken)
+    std::vector<const_cstring> nonterminalNames; // The non-terminal names in the arena (indexed by token - baseNonterminalToken)
+    NameTable terminalTokens;         // All terminal tokens by name
+    NameTable nonterminalTokens;      // All non-terminal (and temporary) tokens by name
+
+    // Hash a name
+    static FORCE_INLINE uint32 HashName(const_cstring name, uint length);
+
+    // Find the slot holding a name (or otherwise the empty slot where it would be inserted)
+    INLINE uint32 FindSlot(const NameTable& table, const_cstring name, uint length, uint32 hash) const;
+
+    // Look up the token identified by a name (returns ParseToken(-1) if the name is not in the table)
+    INLINE ParseToken FindToken(const NameTable& table, const_cstring name, uint length) const;
+
+    // Look up a name in the base snapshot (returns ParseToken(-1) if there is no base snapshot or the name is not in it)
+    INLINE ParseToken FindBaseTerminal(const_cstring name, uint length) const;
+    INLINE ParseToken FindBaseNonterminal(const_cstring name, uint length) const;
+
+    // Get the name of a token of the base snapshot
+    INLINE const_cstring GetBaseTokenName(ParseToken token) const;
+
+    // Copy a name into the arena
+    INLINE const_cstring StoreName(const_cstring name, uint length);
+
+    // Map a name to a token (replacing the token if the name is already in the table) and return the name in the arena
+    INLINE const_cstring InsertToken(NameTable& table, const_cstring name, uint length, ParseToken token);
+
+    // Double the size of a table
+    INLINE void GrowTable(NameTable& table);
   };
 }
 
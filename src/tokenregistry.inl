@@ -11,13 +11,32 @@
 
 namespace QParser
 {
+  const uint TokenRegistry::NAME_BLOCK_LENGTH;
+
   INLINE TokenRegistry::TokenRegistry() :
     nextTerminalToken(TOKEN_TERMINAL_FIRST),
     nextNonterminalToken(TOKEN_NONTERMINAL_FIRST),
-    nextTemporaryToken(~1)
+    nextTemporaryToken(~1),
+    baseTerminalToken(TOKEN_TERMINAL_FIRST),
+    baseNonterminalToken(TOKEN_NONTERMINAL_FIRST),
+    nameBlockEnd(null),
+    nameBlockRemaining(0),
+    namesLength(0)
   {
+    NameSlot emptySlot = { 0, 0, null, ParseToken(-1) };
+    terminalTokens.slots.assign(16, emptySlot);
+    terminalTokens.slotMask = 15;
+    terminalTokens.size = 0;
+    nonterminalTokens.slots.assign(16, emptySlot);
+    nonterminalTokens.slotMask = 15;
+    nonterminalTokens.size = 0;
   }
     
+  INLINE bool TokenRegistry::IsEmpty() const
+  {
+    return nextTerminalToken == baseTerminalToken && nextNonterminalToken == baseNonterminalToken && nextTemporaryToken == ParseToken(~1);
+  }
+
   INLINE ParseToken TokenRegistry::GetNextAvailableTerminal() const
   {
     return nextTerminalToken;
@@ -35,31 +54,46 @@ namespace QParser
   
   INLINE ParseToken TokenRegistry::GenerateTerminal(const_cstring terminalName)
   {
-    // Try to find an existing terminal token with this name
-    TokenValues::const_iterator i = terminalTokens.find(terminalName);
-    if(i != terminalTokens.end())
-      return i->second;
+    return GenerateTerminal(terminalName, (uint)strlen(terminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::GenerateTerminal(const_cstring terminalName, uint nameLength)
+  {
+    // Try to find an existing terminal token with this name (in the base snapshot or the registry)
+    ParseToken token = FindBaseTerminal(terminalName, nameLength);
+    if(token != ParseToken(-1))
+      return token;
+    token = FindToken(terminalTokens, terminalName, nameLength);
+    if(token != ParseToken(-1))
+      return token;
     
     // Generate a new token for this terminal
-    ParseToken token = nextTerminalToken;
+    token = nextTerminalToken;
     ++nextTerminalToken;
     
     // Insert the terminal into the token name registries
-    terminalTokens[terminalName] = token;
-    terminalNames[token] = terminalName;
+    terminalNames.push_back(InsertToken(terminalTokens, terminalName, nameLength, token));
     
     return token;
   }
 
   INLINE ParseToken TokenRegistry::GenerateNonterminal(const_cstring nonterminalName)
   {
-    // Try to find an existing terminal token with this name
-    TokenValues::const_iterator i = nonterminalTokens.find(nonterminalName);
-    if(i != nonterminalTokens.end() && !IsTemporaryToken(i->second))
-      return i->second;
+    return GenerateNonterminal(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::GenerateNonterminal(const_cstring nonterminalName, uint nameLength)
+  {
+    // Try to find an existing nonterminal token with this name (in the base snapshot or the registry)
+    ParseToken token = FindBaseNonterminal(nonterminalName, nameLength);
+    if(token != ParseToken(-1))
+      return token;
+    token = FindToken(nonterminalTokens, nonterminalName, nameLength);
+    if(token != ParseToken(-1) && !IsTemporaryToken(token))
+      return token;
     
     // Generate a new token for this nonterminal
-    ParseToken token = nextNonterminalToken;
+    token = nextNonterminalToken;
     ++nextNonterminalToken;
     
     // If token is in the range of dummy tokens, this will not work. 
@@ -67,13 +101,18 @@ namespace QParser
     OSI_ASSERT(token <= nextTemporaryToken);
     
     // Insert the nonterminal into the token name registries
-    nonterminalTokens[nonterminalName] = token;
-    nonterminalNames[token] = nonterminalName;
+    // (a temporary token with this name is replaced, sharing its name in the arena)
+    nonterminalNames.push_back(InsertToken(nonterminalTokens, nonterminalName, nameLength, token));
     
     return token;
   }
   
   INLINE ParseToken TokenRegistry::GenerateTemporaryToken(const_cstring nonterminalName)
+  {
+    return GenerateTemporaryToken(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::GenerateTemporaryToken(const_cstring nonterminalName, uint nameLength)
   {
     ParseToken token = nextTemporaryToken;
     nextTemporaryToken--;
@@ -84,106 +123,108 @@ namespace QParser
     
     // Insert the nonterminal into the token name registries
     // (don't add it to the nonterminalNames yet: it will be added when the token is resolved to a nonterminal)
-    nonterminalTokens[nonterminalName] = token;    
+    InsertToken(nonterminalTokens, nonterminalName, nameLength, token);
                   
     return token;
   }
   
   INLINE ParseToken TokenRegistry::ResolveTemporaryToken(const_cstring nonterminalName)
+  {
+    return ResolveTemporaryToken(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::ResolveTemporaryToken(const_cstring nonterminalName, uint nameLength)
   {
     // Generate a new nonterminal corresponding to the temporary token's name
     // This automatically replaces its entries in the registry (see GenerateTemporaryToken, GenerateNonterminal)
-    return GenerateNonterminal(nonterminalName);
+    return GenerateNonterminal(nonterminalName, nameLength);
   }
   
   INLINE ParseToken TokenRegistry::GetToken(const_cstring tokenName) const
+  {
+    return GetToken(tokenName, (uint)strlen(tokenName));
+  }
+
+  INLINE ParseToken TokenRegistry::GetToken(const_cstring tokenName, uint nameLength) const
   {
     // Try to find a terminal token with this name
-    TokenValues::const_iterator i = terminalTokens.find(tokenName);
-    if(i != terminalTokens.end())
-      return i->second;
+    ParseToken token = GetTerminal(tokenName, nameLength);
+    if(token != ParseToken(-1))
+      return token;
 
     // Try to find a non-terminal token with this name
-    i = nonterminalTokens.find(tokenName);
-    if(i != nonterminalTokens.end())
-      return i->second;
-    
-    return ParseToken(-1);  // no matching token found
+    return GetNonterminal(tokenName, nameLength);
   }
   
   INLINE ParseToken TokenRegistry::GetTerminal(const_cstring terminalName) const
+  {
+    return GetTerminal(terminalName, (uint)strlen(terminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::GetTerminal(const_cstring terminalName, uint nameLength) const
   {
     // Try to find a terminal token with this name
-    TokenValues::const_iterator i = terminalTokens.find(terminalName);
-    if(i != terminalTokens.end())
-      return i->second;
-    
-    return ParseToken(-1); // no matching terminal token found
+    const ParseToken token = FindBaseTerminal(terminalName, nameLength);
+    return (token != ParseToken(-1))? token : FindToken(terminalTokens, terminalName, nameLength);
   }
     
   INLINE ParseToken TokenRegistry::GetNonterminal(const_cstring nonterminalName) const
+  {
+    return GetNonterminal(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::GetNonterminal(const_cstring nonterminalName, uint nameLength) const
   {
     // Try to find a non-terminal token with this name
-    TokenValues::const_iterator i = nonterminalTokens.find(nonterminalName);
-    if(i != nonterminalTokens.end())
-      return i->second;
-    
-    return ParseToken(-1);  // no matching non-terminal token found
+    const ParseToken token = FindBaseNonterminal(nonterminalName, nameLength);
+    return (token != ParseToken(-1))? token : FindToken(nonterminalTokens, nonterminalName, nameLength);
   }
   
-  INLINE const std::string& TokenRegistry::GetTokenName(ParseToken token) const
+  INLINE const_cstring TokenRegistry::GetTokenName(ParseToken token) const
   {
-    using std::string;
-    static const string tokenUnknownTerminal("[Unknown Terminal]");
-    static const string tokenUnknownNonterminal("[Unknown Nonterminal]");
-    static const string tokenEOF("[Special (EOF)]");
-    static const string tokenIdentifier("[Identifier]");
-    //static const string tokenIdentifierDecl("[Identifier Decl]");
-    //static const string tokenIdentifierRef("[Identifier Ref]");
-    static const string tokenLiteral("[Literal]");
-
     // Lookup terminal token names
     if(IsTerminal(token))
     {
-      switch(token)
-      {
-      case TOKEN_TERMINAL_IDENTIFIER: return tokenIdentifier;
-      case TOKEN_TERMINAL_LITERAL:    return tokenLiteral;
-      case TOKEN_SPECIAL_EOF:         return tokenEOF;
-      //case ID_IDENTIFIER_DECL:      return tokenIdentifierDecl;
-      //case ID_IDENTIFIER_REF:       return tokenIdentifierRef;
-      }
-
-      TokenNames::const_iterator i = terminalNames.find(token);
-      if(i != terminalNames.end() && i->first == token)
-        return i->second;
-      
-      return tokenUnknownTerminal;
+      if(token >= baseTerminalToken && token < nextTerminalToken)
+        return terminalNames[token - baseTerminalToken];
+      if(token >= TOKEN_TERMINAL_FIRST && token < baseTerminalToken)
+        return GetBaseTokenName(token);
     }
-    
     // Look up non-terminal token names
-    TokenNames::const_iterator i = nonterminalNames.find(token);
-    if(i != nonterminalNames.end() && i->first == token)
-      return i->second;
+    else if(token >= baseNonterminalToken && token < nextNonterminalToken)
+      return nonterminalNames[token - baseNonterminalToken];
+    else if(token < baseNonterminalToken)
+      return GetBaseTokenName(token);
 
-    return tokenUnknownNonterminal;
+    return GetSpecialTokenName(token);
+  }
+
+  INLINE const_cstring TokenRegistry::GetSpecialTokenName(ParseToken token)
+  {
+    switch(token)
+    {
+    case TOKEN_TERMINAL_IDENTIFIER: return "[Identifier]";
+    case TOKEN_TERMINAL_LITERAL:    return "[Literal]";
+    case TOKEN_SPECIAL_EOF:         return "[Special (EOF)]";
+    //case ID_IDENTIFIER_DECL:      return "[Identifier Decl]";
+    //case ID_IDENTIFIER_REF:       return "[Identifier Ref]";
+    }
+    return IsTerminal(token)? "[Unknown Terminal]" : "[Unknown Nonterminal]";
   }
   
   INLINE ParseToken TokenRegistry::FindOrGenerateTemporaryNonterminal(const_cstring nonterminalName)
   {
-    ParseToken token = -1;
-    
+    return FindOrGenerateTemporaryNonterminal(nonterminalName, (uint)strlen(nonterminalName));
+  }
+
+  INLINE ParseToken TokenRegistry::FindOrGenerateTemporaryNonterminal(const_cstring nonterminalName, uint nameLength)
+  {
     // Try to find existing an production producing this token name
-    TokenValues::const_iterator i = nonterminalTokens.find(nonterminalName);
-    if(i == nonterminalTokens.end())
+    ParseToken token = GetNonterminal(nonterminalName, nameLength);
+    if(token == ParseToken(-1))
     {
       // Generate a temporary token value for this non-terminal
-      token = GenerateTemporaryToken(nonterminalName);
-    }
-    else
-    {
-      // Return the existing non-terminal token
-      token = i->second;
+      token = GenerateTemporaryToken(nonterminalName, nameLength);
     }
     
     return token;
@@ -199,7 +240,7 @@ namespace QParser
     return !IsTerminal(token);
   }
   
-  INLINE bool TokenRegistry::IsTemporaryToken(ParseToken token)
+  INLINE bool TokenRegistry::IsTemporaryToken(ParseToken token) const
   {
     return token > nextNonterminalToken;
   }
@@ -218,6 +259,102 @@ namespace QParser
   {
     return !IsTerminal(nonterminal) && nonterminal < nextNonterminalToken;
   }
+
+  FORCE_INLINE uint32 TokenRegistry::HashName(const_cstring name, uint length)
+  {
+    // FNV-1a (folded to 32 bits)
+    uint64 hash = 14695981039346656037ULL;
+    for(uint c = 0; c < length; ++c)
+      hash = (hash ^ uint8(name[c])) * 1099511628211ULL;
+    return uint32(hash ^ (hash >> 32));
+  }
+
+  INLINE uint32 TokenRegistry::FindSlot(const NameTable& table, const_cstring name, uint length, uint32 hash) const
+  {
+    // (The table is never more than half full, so an empty slot always terminates the probe sequence)
+    for(uint32 cSlot = hash & table.slotMask;; cSlot = (cSlot + 1) & table.slotMask)
+    {
+      const NameSlot& slot = table.slots[cSlot];
+      if(slot.name == null)
+        return cSlot;
+      if(slot.hash == hash && slot.length == length && memcmp(slot.name, name, length) == 0)
+        return cSlot;
+    }
+  }
+
+  INLINE ParseToken TokenRegistry::FindToken(const NameTable& table, const_cstring name, uint length) const
+  {
+    const NameSlot& slot = table.slots[FindSlot(table, name, length, HashName(name, length))];
+    return slot.name == null? ParseToken(-1) : slot.token;
+  }
+
+  INLINE const_cstring TokenRegistry::StoreName(const_cstring name, uint length)
+  {
+    // Start a new block if the name does not fit into the last one
+    // (the rest of the last block is left unused: the blocks never move once allocated)
+    if(length + 1 > nameBlockRemaining)
+    {
+      const uint blockLength = std::max(NAME_BLOCK_LENGTH, length + 1);
+      nameBlocks.push_back(std::unique_ptr<char[]>(new char[blockLength]));
+      nameBlockEnd = nameBlocks.back().get();
+      nameBlockRemaining = blockLength;
+    }
+
+    char* const storedName = nameBlockEnd;
+    memcpy(storedName, name, length);
+    storedName[length] = '\0';
+    nameBlockEnd += length + 1;
+    nameBlockRemaining -= length + 1;
+    namesLength += length + 1;
+    return storedName;
+  }
+
+  INLINE const_cstring TokenRegistry::InsertToken(NameTable& table, const_cstring name, uint length, ParseToken token)
+  {
+    const uint32 hash = HashName(name, length);
+    NameSlot& slot = table.slots[FindSlot(table, name, length, hash)];
+
+    // Replace the token of an existing name
+    if(slot.name != null)
+    {
+      slot.token = token;
+      return slot.name;
+    }
+
+    // Copy the name into the arena
+    slot.hash = hash;
+    slot.length = length;
+    slot.name = StoreName(name, length);
+    slot.token = token;
+
+    // Keep the table at most half full
+    const_cstring const storedName = slot.name;
+    ++table.size;
+    if(table.size * 2 > table.slots.size())
+      GrowTable(table);
+    return storedName;
+  }
+
+  INLINE void TokenRegistry::GrowTable(NameTable& table)
+  {
+    std::vector<NameSlot> slots(table.slots.size() * 2);
+    for(uint32 c = 0; c < slots.size(); ++c)
+      slots[c].name = null;
+    table.slotMask = (uint32)slots.size() - 1;
+
+    // Reinsert all names (their hashes are kept in the slots)
+    for(uint32 c = 0; c < table.slots.size(); ++c)
+    {
+      const NameSlot& slot = table.slots[c];
+      if(slot.name == null)
+        continue;
+      uint32 cSlot = slot.hash & table.slotMask;
+      while(slots[cSlot].name != null)
+        cSlot = (cSlot + 1) & table.slotMask;
+      slots[cSlot] = slot;
+    }
+    table.slots.swap(slots);
+  }
 }
 
 #endif
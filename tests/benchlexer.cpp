@@ -0,0 +1,324 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//    BENCHLEXER.CPP
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    BENCHMARK:
+      Measure the throughput of the lexer (in MB/s) on generated input.
+      (This program is built along with the unit tests, but it is not run
+      as part of the regression tests)
+ */
+
+/*                                 INCLUDES                                 */
+// QParser
+#include "../src/api.h"
+using namespace QParser;
+
+// QParser unit tests
+#include "testcommon.h"
+
+// STL
+#include <chrono>
+
+/*                                DEFINITIONS                               */
+#define BENCHLEXER_REPETITIONS 20
+
+/*                                 TEST DATA                                */
+// The tokens of BuildBenchLexer as a static lexer definition
+struct BenchTokens
+{
+  static constexpr StaticToken tokens[] =
+  {
+    StaticToken::Bounded(Lexer::TOKENTYPE_RAW, "string", "\"", "\"", OSIX::SINGLE_LINE),
+    StaticToken::Bounded(Lexer::TOKENTYPE_RAW, "comment", "/*", "*/", OSIX::MULTI_LINE),
+    StaticToken::String(Lexer::TOKENTYPE_NIL, "space", " "),
+    StaticToken::String(Lexer::TOKENTYPE_NIL, "newline", "\n"),
+    StaticToken::Bounded(Lexer::TOKENTYPE_NIL, "line comment", "//", "", OSIX::SINGLE_LINE),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "==", "=="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "=", "="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "<=", "<="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "<", "<"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "+", "+"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "-", "-"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "*", "*"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "/", "/"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "(", "("),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, ")", ")"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "{", "{"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "}", "}"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, ";", ";"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "if", "if"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "else", "else"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "while", "while"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "return", "return"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "int", "int")
+  };
+};
+
+/*                                  HELPERS                                 */
+void BuildBenchLexer(Lexer& lexer)
+{
+  lexer.BoundedToken("string", "\"", "\"", OSIX::SINGLE_LINE);
+  lexer.BoundedToken("comment", "/*", "*/", OSIX::MULTI_LINE);
+  lexer.Build(Lexer::TOKENTYPE_RAW);
+
+  lexer.CharToken("space", ' ');
+  lexer.CharToken("newline", '\n');
+  lexer.BoundedToken("line comment", "//", "", OSIX::SINGLE_LINE);
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+
+  const_cstring symbols[] = { "==", "=", "<=", "<", "+", "-", "*", "/", "(", ")", "{", "}", ";", null };
+  for(uint c = 0; symbols[c] != null; ++c)
+    lexer.StringToken(symbols[c], symbols[c]);
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+  const_cstring words[] = { "if", "else", "while", "return", "int", null };
+  for(uint c = 0; words[c] != null; ++c)
+    lexer.StringToken(words[c], words[c]);
+  lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+}
+
+// Generate source code consisting mostly of block comments, line comments and string literals
+std::string GenerateCommentHeavyInput(uint size)
+{
+  std::string input;
+  while(input.length() < size)
+  {
+    input += "/* ";
+    for(uint c = 0; c < 40; ++c)
+      input += "This block comment describes the function below in some detail.\n * ";
+    input += "*/\n";
+    for(uint c = 0; c < 10; ++c)
+      input += "// A line comment that is skipped by the lexer without producing any tokens\n";
+    input += "int f(int x) { if(x <= 1) return \"a fairly long string literal used as a message\"; return x * f(x - 1); }\n";
+  }
+  return input;
+}
+
+// Generate source code consisting mostly of short words and symbols
+std::string GenerateCodeHeavyInput(uint size)
+{
+  std::string input;
+  while(input.length() < size)
+    input += "int f(int x) { if(x <= 1) return 1; else return x * f(x - 1) + g(x) - h(x == 2); }\n";
+  return input;
+}
+
+// Measure the throughput of the lexer on the input
+double MeasureThroughput(const Lexer& lexer, const std::string& input)
+{
+  ParseResult result;
+  result.inputStream.data = input.c_str();
+  result.inputStream.length = (uint)input.length();
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+  {
+    lexer.LexicalAnalysis(result);
+    delete[] result.lexStream.data;
+    result.lexStream.data = null;
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return (double(input.length()) * BENCHLEXER_REPETITIONS / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+// Measure the throughput of the lexer on the input, reusing a single match buffer for every repetition
+double MeasureArenaThroughput(const Lexer& lexer, const std::string& input)
+{
+  MatchBuffer matches;
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+    lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), matches);
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return (double(input.length()) * BENCHLEXER_REPETITIONS / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+// Measure the throughput of the lexer on the input while validating it as UTF-8, reusing a single match buffer for every repetition
+double MeasureValidatedThroughput(const Lexer& lexer, const std::string& input)
+{
+  MatchBuffer matches;
+  ParseOffset invalidUtf8Offset;
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+    lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), 0, matches, null, &invalidUtf8Offset);
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return (double(input.length()) * BENCHLEXER_REPETITIONS / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+// Measure the throughput of the static lexer on the input, reusing a single match buffer for every repetition
+double MeasureStaticThroughput(const std::string& input)
+{
+  MatchBuffer matches;
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+    StaticLexer<BenchTokens>::LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), matches);
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return (double(input.length()) * BENCHLEXER_REPETITIONS / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+// Generate the name of the n'th generated token (using only letters)
+std::string GenerateTokenName(const_cstring prefix, uint n)
+{
+  std::string name = prefix;
+  do
+  {
+    name += char('a' + n % 26);
+    n /= 26;
+  } while(n > 0);
+  return name;
+}
+
+// Generate the value of the n'th generated symbol token (using only operator characters)
+std::string GenerateSymbolValue(uint n)
+{
+  const_cstring characters = "+-*/<>=!&|%^~";
+  std::string value;
+  do
+  {
+    value += characters[n % 13];
+    n /= 13;
+  } while(n > 0);
+  return value;
+}
+
+// Measure the throughput of the lexer on the input followed by zero padding, reusing a single match buffer
+double MeasurePaddedThroughput(const Lexer& lexer, const std::string& input)
+{
+  std::vector<char> paddedInput(input.begin(), input.end());
+  paddedInput.resize(input.length() + lexer.GetInputPadding(), '\0');
+  MatchBuffer matches;
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+    lexer.LexicalAnalysis(&paddedInput[0], (ParseOffset)input.length(), lexer.GetInputPadding(), matches);
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return (double(input.length()) * BENCHLEXER_REPETITIONS / (1024.0 * 1024.0)) / elapsed.count();
+}
+
+// Measure the time taken to lex the input again after inserting and then removing a character in the middle of it (in microseconds)
+double MeasureIncrementalLatency(const Lexer& lexer, const std::string& input)
+{
+  MatchBuffer matches;
+  lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), matches);
+  std::string editedInput = input;
+  const ParseOffset editOffset = (ParseOffset)(input.length() / 2);
+  editedInput.insert(editOffset, 1, 'x');
+
+  const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+  for(uint c = 0; c < BENCHLEXER_REPETITIONS; ++c)
+  {
+    lexer.IncrementalAnalysis(editedInput.c_str(), (ParseOffset)editedInput.length(), 0, editOffset, 0, 1, matches);
+    lexer.IncrementalAnalysis(input.c_str(), (ParseOffset)input.length(), 0, editOffset, 1, 0, matches);
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+  return elapsed.count() * 1000000.0 / (2 * BENCHLEXER_REPETITIONS);
+}
+
+/*                                 BENCHMARKS                               */
+void BenchCommentHeavy()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildBenchLexer(lexer);
+
+  const std::string input = GenerateCommentHeavyInput(4 * 1024 * 1024);
+  const_cstring implementationNames[] = { "scalar", "sse2", "avx2" };
+
+  cout << "Comment heavy input (" << input.length() / 1024 << " KB):" << endl;
+  for(uint implementation = CharScan::IMPLEMENTATION_SCALAR; implementation <= CharScan::IMPLEMENTATION_AVX2; ++implementation)
+  {
+    if(!CharScan::SetImplementation(CharScan::Implementation(implementation)))
+      continue;
+    cout << '\t' << implementationNames[implementation] << ": " << MeasureThroughput(lexer, input) << " MB/s" << endl;
+  }
+}
+
+void BenchCodeHeavy()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildBenchLexer(lexer);
+
+  // (The size of the lex stream elements depends on QPARSER_WIDE_OFFSETS)
+  const std::string input = GenerateCodeHeavyInput(4 * 1024 * 1024);
+  cout << "Code heavy input (" << input.length() / 1024 << " KB, " << sizeof(ParseMatch) << " bytes per lexical token):" << endl;
+  cout << "\tparse result: " << MeasureThroughput(lexer, input) << " MB/s" << endl;
+  cout << "\treused match buffer: " << MeasureArenaThroughput(lexer, input) << " MB/s" << endl;
+  cout << "\tpadded input: " << MeasurePaddedThroughput(lexer, input) << " MB/s" << endl;
+  cout << "\tvalidated UTF-8: " << MeasureValidatedThroughput(lexer, input) << " MB/s" << endl;
+  cout << "\tstatic lexer: " << MeasureStaticThroughput(input) << " MB/s" << endl;
+  cout << "\tincremental edit: " << MeasureIncrementalLatency(lexer, input) << " us" << endl;
+}
+
+void BenchThreads()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildBenchLexer(lexer);
+
+  const std::string input = GenerateCodeHeavyInput(32 * 1024 * 1024);
+  const uint nProcessors = std::max(1u, std::thread::hardware_concurrency());
+  cout << "Code heavy input (" << input.length() / 1024 << " KB, " << nProcessors << " processors):" << endl;
+  for(uint nThreads = 1; nThreads <= nProcessors; nThreads *= 2)
+  {
+    lexer.SetThreadCount(nThreads);
+    cout << '\t' << nThreads << " thread(s): " << MeasureThroughput(lexer, input) << " MB/s" << endl;
+  }
+}
+
+void BenchBuild()
+{
+  cout << "Lexer construction:" << endl;
+  for(uint nWords = 10000; nWords <= 40000; nWords *= 2)
+  {
+    const uint nSymbols = nWords / 10;
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    {
+      ParserLD parser;
+      Lexer lexer(parser.GetTokenRegistry());
+
+      for(uint c = 0; c < nSymbols; ++c)
+      {
+        const std::string value = GenerateSymbolValue(c);
+        lexer.StringToken(GenerateTokenName("symbol ", c).c_str(), value.c_str());
+      }
+      lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+      for(uint c = 0; c < nWords; ++c)
+      {
+        const std::string value = GenerateTokenName("k", c);
+        lexer.StringToken(value.c_str(), value.c_str());
+      }
+      lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    cout << '\t' << nWords << " words, " << nSymbols << " symbols: " << elapsed.count() * 1000.0 << " ms" << endl;
+  }
+}
+
+/*                                ENTRY POINT                               */
+int main()
+{
+  cout << "-----------------------------------" << endl
+       << "Benchmarking Lexer: " << endl;
+  BenchCommentHeavy();
+  BenchCodeHeavy();
+  BenchThreads();
+  BenchBuild();
+  return 0;
+}
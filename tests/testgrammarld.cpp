@@ -223,17 +223,25 @@ class TestGrammarLD : public GrammarLD
 public:
   // Constructor
   TestGrammarLD(TokenRegistry& tokenRegistry) : GrammarLD(tokenRegistry) {}
+
+  // Compute and query the FIRST sets
+  void TEST_ComputeFirstTerminals() { ComputeFirstTerminals(); }
+  bool TEST_GetFirstTerminals(ParseToken token, TerminalSet& firstTerminals) const { return GetFirstTerminals(token, firstTerminals); }
+
+  // Query the production rules
+  uint TEST_GetProductionRuleCount(ParseToken nonterminal) const { return GetProductionSet(nonterminal)->rulesLength; }
+  uint TEST_GetRuleLength(uint ruleIndex) const { return GetRule(ruleIndex).tokensLength; }
   
   // Print out the grammar rules
   void TEST_PrintGrammarRules() const
   {
     cout << "Grammar Rules:" << endl;
-    int cRule = 0;
-    for(auto i = rules.begin(); i != rules.end(); ++i, ++cRule)
+    for(uint cRule = 0; cRule < GetRuleCount(); ++cRule)
     {
-      cout << '\t' << cRule << ". " << tokenRegistry.GetTokenName(i->second) << " ->";      
-      for(auto c = 0; c < i->first.tokensLength; ++c)
-        cout << ' ' << tokenRegistry.GetTokenName(i->first.tokens[c]);
+      const ProductionRule rule = GetRule(cRule);
+      cout << '\t' << cRule << ". " << tokenRegistry.GetTokenName(GetRuleNonterminal(cRule)) << " ->";      
+      for(uint c = 0; c < rule.tokensLength; ++c)
+        cout << ' ' << tokenRegistry.GetTokenName(rule.tokens[c]);
       cout << endl;
     }
   }
@@ -285,6 +293,14 @@ bool TestGrammar1()
 #ifdef TESTGRAMMARLD_DEBUG_INFO
   cout << endl;
 #endif
+
+  // The FIRST sets are computed when the construction of the parse table starts
+  TerminalSet firstTerminals;
+  if(grammar.TEST_GetFirstTerminals(parser.GetTokenRegistry().GetNonterminal("D"), firstTerminals) || !firstTerminals.Contains(x) || firstTerminals.Contains(y))
+  {
+    cout << "Error: FIRST(D) does not match the expected outcome" << endl;
+    return false;
+  }
   
   // Print out the grammar rules
 #ifdef TESTGRAMMARLD_DEBUG_INFO
@@ -361,13 +377,325 @@ bool TestGrammar1()
   return true;
 }
 
+bool TestGrammar2()
+{
+  TestParserLD parser;
+  TokenRegistry& tokenRegistry = parser.GetTokenRegistry();
+  const uint N_TOKENS = 100000;
+
+  //// Generate a large number of terminals, nonterminals and forward declared (temporary) nonterminals
+  char name[32];
+  for(uint c = 0; c < N_TOKENS; ++c)
+  {
+    sprintf(name, "t%u", c);
+    if(tokenRegistry.GenerateTerminal(name) != TOKEN_TERMINAL_FIRST + c)
+    {
+      cout << "Error: terminal " << name << " was not generated sequentially" << endl;
+      return false;
+    }
+  }
+  const_cstring const firstTerminalName = tokenRegistry.GetTokenName(TOKEN_TERMINAL_FIRST); // (must remain valid while more tokens are added)
+  for(uint c = 0; c < N_TOKENS; ++c)
+  {
+    sprintf(name, "n%u", c);
+    if(c % 2 == 0)
+      tokenRegistry.FindOrGenerateTemporaryNonterminal(name);
+    else
+      tokenRegistry.GenerateNonterminal(name);
+  }
+  for(uint c = 0; c < N_TOKENS; c += 2)
+  {
+    sprintf(name, "n%u", c);
+    if(!tokenRegistry.IsTemporaryToken(tokenRegistry.GetNonterminal(name)))
+    {
+      cout << "Error: nonterminal " << name << " should be temporary" << endl;
+      return false;
+    }
+    tokenRegistry.ResolveTemporaryToken(name);
+  }
+
+  //// Look up every token by name and every name by token
+  for(uint c = 0; c < N_TOKENS; ++c)
+  {
+    sprintf(name, "t%u", c);
+    ParseToken token = tokenRegistry.GetToken(name);
+    if(token != TOKEN_TERMINAL_FIRST + c || strcmp(tokenRegistry.GetTokenName(token), name) != 0 || tokenRegistry.GenerateTerminal(name) != token)
+    {
+      cout << "Error: terminal " << name << " does not match its name" << endl;
+      return false;
+    }
+
+    sprintf(name, "n%u", c);
+    token = tokenRegistry.GetNonterminal(name);
+    if(!tokenRegistry.IsNonterminalValid(token) || strcmp(tokenRegistry.GetTokenName(token), name) != 0 || tokenRegistry.GenerateNonterminal(name) != token)
+    {
+      cout << "Error: nonterminal " << name << " does not match its name" << endl;
+      return false;
+    }
+  }
+  //// Look up names that are not null terminated
+  const char names[] = "t12n345missing";
+  if(tokenRegistry.GetToken(names, 3) != TOKEN_TERMINAL_FIRST + 12
+    || tokenRegistry.GetNonterminal(names + 3, 4) != tokenRegistry.GetNonterminal("n345")
+    || tokenRegistry.GetTerminal(names + 3, 4) != ParseToken(-1)
+    || tokenRegistry.GenerateTerminal(names, 2) != TOKEN_TERMINAL_FIRST + 1)
+  {
+    cout << "Error: token names given by length do not match" << endl;
+    return false;
+  }
+
+  //// Look up every token in a frozen snapshot of the registry shared by several threads
+  std::shared_ptr<const FrozenTokenRegistry> frozenTokenRegistry = parser.FreezeTokenRegistry();
+  tokenRegistry.FindOrGenerateTemporaryNonterminal("unresolved");
+  if(parser.FreezeTokenRegistry() != frozenTokenRegistry)
+  {
+    cout << "Error: token registry was frozen again without any new tokens" << endl;
+    return false;
+  }
+  bool frozenTokensMatch[4];
+  std::vector<std::thread> threads;
+  for(uint cThread = 0; cThread < 4; ++cThread)
+    threads.push_back(std::thread([&, cThread]()
+    {
+      char name[32];
+      frozenTokensMatch[cThread] = frozenTokenRegistry->GetToken("unresolved") == ParseToken(-1)
+        && frozenTokenRegistry->GetToken(names, 3) == TOKEN_TERMINAL_FIRST + 12
+        && strcmp(frozenTokenRegistry->GetTokenName(TOKEN_TERMINAL_LITERAL), "[Literal]") == 0;
+      for(uint c = cThread; c < N_TOKENS; c += 4)
+      {
+        sprintf(name, "t%u", c);
+        ParseToken token = frozenTokenRegistry->GetToken(name);
+        frozenTokensMatch[cThread] &= token == tokenRegistry.GetTerminal(name) && strcmp(frozenTokenRegistry->GetTokenName(token), name) == 0;
+        sprintf(name, "n%u", c);
+        token = frozenTokenRegistry->GetToken(name);
+        frozenTokensMatch[cThread] &= token == tokenRegistry.GetNonterminal(name) && frozenTokenRegistry->IsNonterminalValid(token) && strcmp(frozenTokenRegistry->GetTokenName(token), name) == 0;
+      }
+    }));
+  for(uint cThread = 0; cThread < 4; ++cThread)
+  {
+    threads[cThread].join();
+    if(!frozenTokensMatch[cThread])
+    {
+      cout << "Error: frozen token registry does not match the token registry" << endl;
+      return false;
+    }
+  }
+
+  //// Share the snapshot with a parser that builds its token registry against it
+  TestParserLD sharingParser;
+  TokenRegistry& sharingTokenRegistry = sharingParser.GetTokenRegistry();
+  sharingParser.AdoptTokenRegistry(frozenTokenRegistry);
+  if(sharingParser.FreezeTokenRegistry() != frozenTokenRegistry || sharingTokenRegistry.GetNextAvailableTerminal() != TOKEN_TERMINAL_FIRST + N_TOKENS
+    || sharingParser.GetToken(names, 3) != TOKEN_TERMINAL_FIRST + 12 || strcmp(sharingParser.GetTokenName(TOKEN_TERMINAL_FIRST + 12), "t12") != 0
+    || !sharingParser.IsTerminal(TOKEN_TERMINAL_FIRST + 12) || sharingParser.IsTerminal(sharingParser.GetToken("n345", 4))
+    || !sharingParser.IsTokenValid(sharingParser.GetToken("n345", 4)) || sharingParser.IsTokenValid(TOKEN_TERMINAL_FIRST + N_TOKENS))
+  {
+    cout << "Error: adopted token registry does not match the token registry" << endl;
+    return false;
+  }
+
+  // (Registering the tokens of the snapshot again, in any order, finds them in the snapshot without storing their names again.
+  //  Other tokens are assigned after the tokens of the snapshot.)
+  const ParseToken sharedTerminal = sharingTokenRegistry.GenerateTerminal("t12");
+  const ParseToken sharedNonterminal = sharingTokenRegistry.FindOrGenerateTemporaryNonterminal("n345");
+  const ParseToken ownTerminal = sharingTokenRegistry.GenerateTerminal("own");
+  sharingTokenRegistry.FindOrGenerateTemporaryNonterminal("ownNonterminal");
+  const ParseToken ownNonterminal = sharingTokenRegistry.ResolveTemporaryToken("ownNonterminal");
+  if(sharedTerminal != TOKEN_TERMINAL_FIRST + 12 || sharedNonterminal != tokenRegistry.GetNonterminal("n345")
+    || sharingTokenRegistry.GetTokenName(sharedTerminal) != frozenTokenRegistry->GetTokenName(sharedTerminal)
+    || ownTerminal != TOKEN_TERMINAL_FIRST + N_TOKENS || ownNonterminal != TOKEN_NONTERMINAL_FIRST + N_TOKENS
+    || strcmp(sharingParser.GetTokenName(ownTerminal), "own") != 0 || strcmp(sharingParser.GetTokenName(ownNonterminal), "ownNonterminal") != 0
+    || sharingParser.GetToken("own", 3) != ownTerminal || strcmp(sharingParser.GetTokenName(TOKEN_TERMINAL_FIRST + 13), "t13") != 0)
+  {
+    cout << "Error: tokens registered against an adopted token registry do not match" << endl;
+    return false;
+  }
+  const std::shared_ptr<const FrozenTokenRegistry> extendedTokenRegistry = sharingParser.FreezeTokenRegistry();
+  if(extendedTokenRegistry == frozenTokenRegistry || extendedTokenRegistry->GetToken("own") != ownTerminal
+    || extendedTokenRegistry->GetToken("t12") != sharedTerminal || strcmp(extendedTokenRegistry->GetTokenName(sharedNonterminal), "n345") != 0)
+  {
+    cout << "Error: token registry built against an adopted token registry was not frozen with its own tokens" << endl;
+    return false;
+  }
+
+  //// Names of tokens registered after the snapshot are looked up in the token registry
+  const ParseToken newTerminal = tokenRegistry.GenerateTerminal("new");
+  if(strcmp(parser.GetTokenName(newTerminal), "new") != 0 || parser.GetToken("new", 3) != newTerminal || !parser.IsTokenValid(newTerminal))
+  {
+    cout << "Error: tokens registered after the snapshot do not match" << endl;
+    return false;
+  }
+
+  if(tokenRegistry.GetNextAvailableNonterminal() != TOKEN_NONTERMINAL_FIRST + N_TOKENS
+    || tokenRegistry.GetTokenName(TOKEN_TERMINAL_FIRST) != firstTerminalName || strcmp(firstTerminalName, "t0") != 0
+    || tokenRegistry.GetToken("missing") != ParseToken(-1)
+    || strcmp(tokenRegistry.GetTokenName(TOKEN_TERMINAL_IDENTIFIER), "[Identifier]") != 0)
+  {
+    cout << "Error: token registry is inconsistent" << endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool TestGrammar3()
+{
+  TestParserLD parser;
+  TestGrammarLD grammar(parser.GetTokenRegistry());
+  Lexer lexer(parser.GetTokenRegistry());
+  x = lexer.CharToken("x", 'x');
+  y = lexer.CharToken("y", 'y');
+  z = lexer.CharToken("z", 'z');
+  w = lexer.CharToken("w", 'w');
+  lexer.Build(QParser::Lexer::TOKENTYPE_LEX_WORD);
+
+  // S -> A B x
+  grammar.BeginProduction("S");
+    grammar.ProductionToken("A");
+    grammar.ProductionToken("B");
+    grammar.ProductionToken("x");
+  grammar.EndProduction();
+
+  // E -> E w | A     (left recursive, nullable through A)
+  grammar.BeginProduction("E");
+    grammar.ProductionToken("E");
+    grammar.ProductionToken("w");
+  grammar.EndProduction();
+  grammar.BeginProduction("E");
+    grammar.ProductionToken("A");
+  grammar.EndProduction();
+
+  // B -> A z | A     (forward declares A)
+  grammar.BeginProduction("B");
+    grammar.ProductionToken("A");
+    grammar.ProductionToken("z");
+  grammar.EndProduction();
+  grammar.BeginProduction("B");
+    grammar.ProductionToken("A");
+  grammar.EndProduction();
+
+  // A -> | y A
+  grammar.BeginProduction("A");
+  grammar.EndProduction();
+  grammar.BeginProduction("A");
+    grammar.ProductionToken("y");
+    grammar.ProductionToken("A");
+  grammar.EndProduction();
+
+  // C -> D x ; D -> C y | z     (mutually recursive, not nullable)
+  grammar.BeginProduction("C");
+    grammar.ProductionToken("D");
+    grammar.ProductionToken("x");
+  grammar.EndProduction();
+  grammar.BeginProduction("D");
+    grammar.ProductionToken("C");
+    grammar.ProductionToken("y");
+  grammar.EndProduction();
+  grammar.BeginProduction("D");
+    grammar.ProductionToken("z");
+  grammar.EndProduction();
+
+  if(!grammar.CheckForwardDeclarations())
+    return false;
+  grammar.TEST_ComputeFirstTerminals();
+
+  // The expected nullability and FIRST set of every nonterminal (in the terminal order x, y, z, w)
+  const struct { const_cstring name; bool nullable; bool first[4]; } expected[] =
+  {
+    { "S", false, { true, true, true, false } },
+    { "E", true,  { false, true, false, true } },
+    { "B", true,  { false, true, true, false } },
+    { "A", true,  { false, true, false, false } },
+    { "C", false, { false, false, true, false } },
+    { "D", false, { false, false, true, false } }
+  };
+  const ParseToken terminals[] = { x, y, z, w };
+  for(uint c = 0; c < sizeof(expected) / sizeof(expected[0]); ++c)
+  {
+    TerminalSet firstTerminals;
+    bool nullable = grammar.TEST_GetFirstTerminals(parser.GetTokenRegistry().GetNonterminal(expected[c].name), firstTerminals);
+    bool match = nullable == expected[c].nullable;
+    for(uint cTerminal = 0; cTerminal < 4; ++cTerminal)
+      match &= firstTerminals.Contains(terminals[cTerminal]) == expected[c].first[cTerminal];
+    if(!match)
+    {
+      cout << "Error: FIRST(" << expected[c].name << ") does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool TestGrammar4()
+{
+  TestParserLD parser;
+  TestGrammarLD grammar(parser.GetTokenRegistry());
+  Lexer lexer(parser.GetTokenRegistry());
+  x = lexer.CharToken("x", 'x');
+  y = lexer.CharToken("y", 'y');
+  lexer.Build(QParser::Lexer::TOKENTYPE_LEX_WORD);
+
+  // L -> x | x x | ... (300 alternatives, the last of which has 300 symbols)
+  const uint N_ALTERNATIVES = 300;
+  for(uint c = 0; c < N_ALTERNATIVES; ++c)
+  {
+    grammar.BeginProduction("L");
+    for(uint cToken = 0; cToken <= c; ++cToken)
+      grammar.ProductionToken("x");
+    grammar.EndProduction();
+  }
+
+  // S -> L y
+  grammar.BeginProduction("S");
+    grammar.ProductionToken("L");
+    grammar.ProductionToken("y");
+  grammar.EndProduction();
+
+  const TokenRegistry& tokenRegistry = parser.GetTokenRegistry();
+  if(grammar.TEST_GetProductionRuleCount(tokenRegistry.GetNonterminal("L")) != N_ALTERNATIVES
+    || grammar.TEST_GetRuleLength(N_ALTERNATIVES - 1) != N_ALTERNATIVES
+    || grammar.TEST_GetRuleLength(N_ALTERNATIVES) != 2)
+  {
+    cout << "Error: production rules do not match the expected outcome" << endl;
+    return false;
+  }
+
+  //// Build the same language against a snapshot of the tokens (defining the tokens in a different order)
+  // (No tokens need to be stored by the token registry of the second parser)
+  TestParserLD sharingParser;
+  sharingParser.AdoptTokenRegistry(parser.FreezeTokenRegistry());
+  TestGrammarLD sharingGrammar(sharingParser.GetTokenRegistry());
+  Lexer sharingLexer(sharingParser.GetTokenRegistry());
+  const ParseToken sharedY = sharingLexer.CharToken("y", 'y');
+  const ParseToken sharedX = sharingLexer.CharToken("x", 'x');
+  sharingLexer.Build(QParser::Lexer::TOKENTYPE_LEX_WORD);
+  sharingGrammar.BeginProduction("S");
+    sharingGrammar.ProductionToken("L");
+    sharingGrammar.ProductionToken("y");
+  sharingGrammar.EndProduction();
+  sharingGrammar.BeginProduction("L");
+    sharingGrammar.ProductionToken("x");
+  sharingGrammar.EndProduction();
+
+  const TokenRegistry& sharingTokenRegistry = sharingParser.GetTokenRegistry();
+  if(sharedX != x || sharedY != y || !sharingGrammar.CheckForwardDeclarations() || !sharingTokenRegistry.IsEmpty()
+    || sharingTokenRegistry.GetNonterminal("L") != tokenRegistry.GetNonterminal("L") || sharingTokenRegistry.GetNonterminal("S") != tokenRegistry.GetNonterminal("S")
+    || sharingGrammar.TEST_GetProductionRuleCount(sharingTokenRegistry.GetNonterminal("L")) != 1)
+  {
+    cout << "Error: language built against a shared token registry does not match" << endl;
+    return false;
+  }
+  return true;
+}
+
 /*                                ENTRY POINT                               */
 int main()
 {
   cout << "-----------------------------------" << endl
        << "Testing GrammarLD: " << endl;
   cout.flush();
-  if (TestGrammar1())  
+  if (TestGrammar1() && TestGrammar2() && TestGrammar3() && TestGrammar4())  
   {
     cout << "SUCCESS" << endl;
     cout.flush();
@@ -0,0 +1,952 @@
+//////////////////////////////////////////////////////////////////////////////
+//
+//    TESTLEXER.CPP
+//
+//    Copyright © 2009, Rehno Lindeque. All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////
+/*                               DOCUMENTATION                              */
+/*
+    UNIT TEST:
+      Test the lexer functionality
+ */
+
+/*                                 INCLUDES                                 */
+// QParser
+#include "../src/api.h"
+using namespace QParser;
+
+// QParser unit tests
+#include "testcommon.h"
+
+/*                                DEFINITIONS                               */
+#define TESTLEXER_DEBUG_INFO
+
+/*                                 TEST DATA                                */
+// Lexical tokens to use
+ParseToken tokenString = 0, tokenComment = 0, tokenLineComment = 0, tokenSpace = 0, tokenNewline = 0;
+ParseToken tokenAssign = 0, tokenEquals = 0, tokenLess = 0, tokenLessEqual = 0, tokenShiftLeft = 0, tokenPlus = 0, tokenIncrement = 0;
+ParseToken tokenIf = 0, tokenElse = 0;
+
+// Lexical tokens of the static lexer (the same tokens as BuildTestLexer1)
+struct StaticTestTokens
+{
+  static constexpr StaticToken tokens[] =
+  {
+    StaticToken::Bounded(Lexer::TOKENTYPE_RAW, "string", "\"", "\"", OSIX::SINGLE_LINE),
+    StaticToken::Bounded(Lexer::TOKENTYPE_RAW, "comment", "/*", "*/", OSIX::MULTI_LINE),
+    StaticToken::String(Lexer::TOKENTYPE_NIL, "space", " "),
+    StaticToken::String(Lexer::TOKENTYPE_NIL, "newline", "\n"),
+    StaticToken::Bounded(Lexer::TOKENTYPE_NIL, "line comment", "//", "", OSIX::SINGLE_LINE),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "<", "<"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "<=", "<="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "<<", "<<"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "==", "=="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "=", "="),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "++", "++"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_SYMBOL, "+", "+"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "if", "if"),
+    StaticToken::String(Lexer::TOKENTYPE_LEX_WORD, "else", "else")
+  };
+};
+
+/*                                  HELPERS                                 */
+void PrintLexStream(const ParseResult& result)
+{
+  cout << "\tLex stream:";
+  for(uint c = 0; c < result.lexStream.length; ++c)
+  {
+    const ParseMatch& match = result.lexStream.data[c];
+    cout << ' ' << (match.token & ~TOKEN_FLAG_SHIFT) << '[' << match.offset << ',' << match.length << ']';
+  }
+  cout << endl;
+}
+
+// Perform lexical analysis on the input and compare the result against the expected tokens
+bool TestLexStream(Lexer& lexer, const_cstring input, const ParseToken* expectedBegin, const ParseToken* expectedEnd)
+{
+  ParseResult result;
+  result.inputStream.data = input;
+  result.inputStream.length = (uint)strlen(input);
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  lexer.LexicalAnalysis(result);
+
+#ifdef TESTLEXER_DEBUG_INFO
+  cout << "\tInput: \"" << input << '\"' << endl;
+  PrintLexStream(result);
+#endif
+
+  if(result.lexStream.length != uint(expectedEnd - expectedBegin))
+  {
+    cout << "Error: the number of lexical tokens does not match the expected outcome" << endl;
+    return false;
+  }
+
+  for(uint c = 0; c < result.lexStream.length; ++c)
+  {
+    if(result.lexStream.data[c].token != expectedBegin[c])
+    {
+      cout << "Error: lexical token does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/*                                   TESTS                                  */
+void BuildTestLexer1(Lexer& lexer)
+{
+  // Raw tokens
+  tokenString = lexer.BoundedToken("string", "\"", "\"", OSIX::SINGLE_LINE);
+  tokenComment = lexer.BoundedToken("comment", "/*", "*/", OSIX::MULTI_LINE);
+  lexer.Build(Lexer::TOKENTYPE_RAW);
+
+  // Nil tokens
+  tokenSpace = lexer.CharToken("space", ' ');
+  tokenNewline = lexer.CharToken("newline", '\n');
+  tokenLineComment = lexer.BoundedToken("line comment", "//", "", OSIX::SINGLE_LINE);
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+
+  // Lex symbols
+  // (Note that tokens sharing a prefix are matched in the order that they were defined)
+  tokenLess = lexer.CharToken("<", '<');
+  tokenLessEqual = lexer.StringToken("<=", "<=");
+  tokenShiftLeft = lexer.StringToken("<<", "<<");
+  tokenEquals = lexer.StringToken("==", "==");
+  tokenAssign = lexer.CharToken("=", '=');
+  tokenIncrement = lexer.StringToken("++", "++");
+  tokenPlus = lexer.CharToken("+", '+');
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+  // Lex words
+  tokenIf = lexer.StringToken("if", "if");
+  tokenElse = lexer.StringToken("else", "else");
+  lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+}
+
+bool TestLexer1()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  const ParseToken identifier = TOKEN_TERMINAL_IDENTIFIER;
+  const ParseToken literal = TOKEN_TERMINAL_LITERAL;
+
+  // Words, keywords and operators
+  ParseToken expected1[] = { tokenIf, identifier, tokenEquals, literal, tokenAssign, identifier, tokenIncrement, tokenElse, identifier };
+  if(!TestLexStream(lexer, "if x == 10 = y++ else ifx", expected1, expected1 + sizeof(expected1)/sizeof(ParseToken)))
+    return false;
+
+  // Operators sharing a common prefix (the first token defined takes precedence)
+  ParseToken expected2[] = { identifier, tokenLess, tokenLess, identifier, tokenLess, tokenAssign, identifier, tokenEquals, tokenAssign };
+  if(!TestLexStream(lexer, "a<<b<=c===", expected2, expected2 + sizeof(expected2)/sizeof(ParseToken)))
+    return false;
+
+  // Bounded tokens and nil tokens
+  ParseToken expected3[] = { identifier, tokenComment, tokenString, tokenPlus, identifier };
+  if(!TestLexStream(lexer, "a/* x\n y */\"s + t\"+ b // c\n", expected3, expected3 + sizeof(expected3)/sizeof(ParseToken)))
+    return false;
+
+  // Unterminated single-line bounded token (falls back to words and other symbols)
+  ParseToken expected4[] = { identifier, literal };
+  if(!TestLexStream(lexer, "\"abc\n12", expected4, expected4 + sizeof(expected4)/sizeof(ParseToken)))
+    return false;
+
+  return true;
+}
+
+bool TestLexer2()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Build long comments, strings, words and whitespace so that the vectorized scanning routines are exercised
+  std::string input = "a /*";
+  for(uint c = 0; c < 100; ++c)
+    input += (c % 7 == 0)? "* / \n" : "comment ";
+  input += "*/ \"";
+  for(uint c = 0; c < 100; ++c)
+    input += "string ";
+  input += "\" // ";
+  for(uint c = 0; c < 100; ++c)
+    input += "line ";
+  input += "\n\"";
+  for(uint c = 0; c < 100; ++c)
+    input += "unterminated ";
+  input += "\n";
+  for(uint c = 0; c < 100; ++c)
+    input += "word";
+  for(uint c = 0; c < 100; ++c)
+    input += (c % 9 == 0)? "\n" : "  ";
+  input += "b";
+
+  for(uint implementation = CharScan::IMPLEMENTATION_SCALAR; implementation <= CharScan::IMPLEMENTATION_AVX2; ++implementation)
+  {
+    if(!CharScan::SetImplementation(CharScan::Implementation(implementation)))
+      continue;
+#ifdef TESTLEXER_DEBUG_INFO
+    cout << "\tCharacter scan implementation: " << implementation << endl;
+#endif
+
+    ParseResult result;
+    result.inputStream.data = input.c_str();
+    result.inputStream.length = (uint)input.length();
+    result.inputStream.elementSize = sizeof(char);
+    result.lexStream.elementSize = sizeof(ParseMatch);
+    lexer.LexicalAnalysis(result);
+
+    // (The unterminated string falls back to one word per repetition)
+    if(result.lexStream.length != 3 + 100 + 2 || result.lexStream.data[3 + 100].length != 400 || result.lexStream.data[3 + 100 + 1].offset != input.length() - 1)
+    {
+      cout << "Error: the number of lexical tokens does not match the expected outcome" << endl;
+      return false;
+    }
+
+    const ParseMatch& comment = result.lexStream.data[1];
+    const ParseMatch& string = result.lexStream.data[2];
+    if(comment.token != tokenComment || comment.offset != 2 || input.compare(comment.offset + comment.length - 2, 3, "*/ ") != 0
+      || string.token != tokenString || input.compare(string.offset + string.length - 1, 2, "\" ") != 0)
+    {
+      cout << "Error: bounded token does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestLexer3()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Words longer than 255 characters
+  std::string input = std::string(300, 'x') + " " + std::string(300, '9');
+#ifdef QPARSER_WIDE_OFFSETS
+  // Tokens longer than (and beyond) 64 KB
+  input += " /*" + std::string(70000, ' ') + "*/ y";
+#endif
+
+  ParseResult result;
+  result.inputStream.data = input.c_str();
+  result.inputStream.length = (ParseOffset)input.length();
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  lexer.LexicalAnalysis(result);
+
+#ifdef QPARSER_WIDE_OFFSETS
+  const uint expectedLength = 4;
+#else
+  const uint expectedLength = 2;
+#endif
+  if(result.lexStream.length != expectedLength
+    || result.lexStream.data[0].token != TOKEN_TERMINAL_IDENTIFIER || result.lexStream.data[0].offset != 0 || result.lexStream.data[0].length != 300
+    || result.lexStream.data[1].token != TOKEN_TERMINAL_LITERAL || result.lexStream.data[1].offset != 301 || result.lexStream.data[1].length != 300)
+  {
+    cout << "Error: long lexical tokens do not match the expected outcome" << endl;
+    return false;
+  }
+
+#ifdef QPARSER_WIDE_OFFSETS
+  if(result.lexStream.data[2].token != tokenComment || result.lexStream.data[2].offset != 602 || result.lexStream.data[2].length != 70004
+    || result.lexStream.data[3].token != TOKEN_TERMINAL_IDENTIFIER || result.lexStream.data[3].offset != 70607)
+  {
+    cout << "Error: wide lexical tokens do not match the expected outcome" << endl;
+    return false;
+  }
+#endif
+  return true;
+}
+
+bool TestLexer4()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  const_cstring inputs[] = { "if x == 10 = y++ else ifx", "a<<b<=c===", "a/* x\n y */\"s + t\"+ b // c\n", "\"abc\n12", "x // no newline", null };
+  for(uint cInput = 0; inputs[cInput] != null; ++cInput)
+  {
+    const_cstring input = inputs[cInput];
+    const ParseOffset inputLength = (ParseOffset)strlen(input);
+
+    // Lex the whole input at once
+    MatchBuffer expected;
+    lexer.LexicalAnalysis(input, inputLength, expected);
+
+    // Stream the input in chunks of various sizes
+    for(ParseOffset chunkLength = 1; chunkLength <= 4; ++chunkLength)
+    {
+      LexerStream stream(lexer);
+      LexerStream::Matches matches;
+      for(ParseOffset c = 0; c < inputLength; c += chunkLength)
+        stream.Feed(input + c, std::min(chunkLength, inputLength - c), matches);
+      stream.Finish(matches);
+
+      bool match = (matches.GetLength() == expected.GetLength());
+      for(uint c = 0; match && c < matches.GetLength(); ++c)
+        match = matches[c].token == expected[c].token && matches[c].offset == expected[c].offset && matches[c].length == expected[c].length;
+      if(!match)
+      {
+        cout << "Error: streamed lexical tokens do not match the expected outcome (chunk length " << chunkLength << ")" << endl;
+        cout << "\tInput: \"" << input << '\"' << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestLexer5()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Build a large input with comments and strings that cross the lines where the input is split between threads
+  std::string input;
+  for(uint c = 0; input.length() < 4 * 1024 * 1024; ++c)
+  {
+    input += (c % 3 == 0)? "x = y + 1; /* a comment\n spanning lines */ if z" : "\"s\" <= 20 // c\n";
+    input += (c % 5 == 0)? "\n" : " ";
+  }
+
+  ParseResult expected, result;
+  expected.inputStream.data = result.inputStream.data = input.c_str();
+  expected.inputStream.length = result.inputStream.length = (ParseOffset)input.length();
+  lexer.LexicalAnalysis(expected);
+  lexer.SetThreadCount(4);
+  lexer.LexicalAnalysis(result);
+
+  bool match = (result.lexStream.length == expected.lexStream.length);
+  for(uint c = 0; match && c < result.lexStream.length; ++c)
+    match = result.lexStream.data[c].token == expected.lexStream.data[c].token && result.lexStream.data[c].offset == expected.lexStream.data[c].offset && result.lexStream.data[c].length == expected.lexStream.data[c].length;
+  if(!match)
+  {
+    cout << "Error: multi-threaded lexical tokens do not match the expected outcome" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool TestLexer6()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  lexer.CharToken("space", ' ');
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+
+  // Enough keywords to be looked up through the keyword hash (and more than 255 sharing a root character), including
+  // keywords that share a prefix, keywords that differ only in characters that are not sampled by the hash and a
+  // keyword that is defined twice
+  std::vector<std::string> keywords;
+  for(uint c = 0; c < 300; ++c)
+  {
+    std::string keyword = "k";
+    for(uint n = c; n > 0; n /= 26)
+      keyword += char('a' + n % 26);
+    keywords.push_back(keyword);
+  }
+  keywords.push_back("abXdefghi");
+  keywords.push_back("abYdefghi");
+  keywords.push_back("while");
+
+  std::vector<ParseToken> keywordTokens;
+  for(uint c = 0; c < keywords.size(); ++c)
+    keywordTokens.push_back(lexer.StringToken(keywords[c].c_str(), keywords[c].c_str()));
+  lexer.StringToken("while (again)", "while");
+  lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+
+  // Lex every keyword along with words that resemble keywords
+  std::string input;
+  std::vector<ParseToken> expected;
+  for(uint c = 0; c < keywords.size(); ++c)
+  {
+    input += keywords[c] + ' ' + keywords[c] + "_ " + keywords[c].substr(0, keywords[c].length() - 1) + "Z 1" + keywords[c] + ' ';
+    expected.push_back(keywordTokens[c]);
+    expected.push_back(TOKEN_TERMINAL_IDENTIFIER);
+    expected.push_back(TOKEN_TERMINAL_IDENTIFIER);
+    expected.push_back(TOKEN_TERMINAL_LITERAL);
+  }
+  input += "abZdefghi";
+  expected.push_back(TOKEN_TERMINAL_IDENTIFIER);
+
+  if(!TestLexStream(lexer, input.c_str(), &expected[0], &expected[0] + expected.size()))
+  {
+    cout << "Error: keywords were not classified correctly" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool TestLexer7()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Lex inputs that end inside (or right after) tokens with and without padding
+  const_cstring inputs[] = { "a /* b */ c", "a /* b *", "\"s\" <= \"t", "x // y", "x <", "x <<", "\"", "/*", null };
+  for(uint c = 0; inputs[c] != null; ++c)
+  {
+    const ParseOffset inputLength = (ParseOffset)strlen(inputs[c]);
+    std::vector<char> paddedInput(inputs[c], inputs[c] + inputLength);
+    paddedInput.resize(inputLength + lexer.GetInputPadding(), '\0');
+
+    MatchBuffer expected, result;
+    lexer.LexicalAnalysis(inputs[c], inputLength, expected);
+    lexer.LexicalAnalysis(&paddedInput[0], inputLength, lexer.GetInputPadding(), result);
+
+    bool match = (result.GetLength() == expected.GetLength());
+    for(uint cMatch = 0; match && cMatch < result.GetLength(); ++cMatch)
+      match = result[cMatch].token == expected[cMatch].token && result[cMatch].offset == expected[cMatch].offset && result[cMatch].length == expected[cMatch].length;
+    if(!match)
+    {
+      cout << "Error: lexical tokens of padded input do not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestLexer8()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Intern identifiers (including enough distinct identifiers to grow the symbol table)
+  std::string input = "alpha = beta + alpha if gamma + 12 \"alpha\" beta // alpha\n";
+  for(uint c = 0; c < 200; ++c)
+    input += "identifier" + std::string(1, char('a' + c % 26)) + std::string(1, char('a' + c / 26)) + " ";
+  input += "alpha";
+
+  SymbolTable symbolTable;
+  ParseResult result;
+  result.inputStream.data = input.c_str();
+  result.inputStream.length = (ParseOffset)input.length();
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  result.symbolTable = &symbolTable;
+  lexer.LexicalAnalysis(result);
+
+  // (alpha = beta + alpha if gamma + 12 "alpha" beta identifier... alpha)
+  const SymbolTable::SymbolId* symbols = result.symbolStream.data;
+  if(result.symbolStream.length != result.lexStream.length || result.lexStream.length != 11 + 200 + 1)
+  {
+    cout << "Error: the number of symbols does not match the expected outcome" << endl;
+    return false;
+  }
+
+  if(symbols[0] != 0 || symbols[2] != 1 || symbols[4] != 0 || symbols[6] != 2 || symbols[10] != 1 || symbols[11 + 200] != 0
+    || symbols[1] != SymbolTable::SYMBOL_NONE || symbols[5] != SymbolTable::SYMBOL_NONE || symbols[8] != SymbolTable::SYMBOL_NONE || symbols[9] != SymbolTable::SYMBOL_NONE
+    || symbolTable.GetSymbolCount() != 3 + 200 || std::string(symbolTable.GetText(2)) != "gamma" || symbolTable.GetLength(2) != 5
+    || symbolTable.Find("beta", 4) != 1 || symbolTable.Find("delta", 5) != SymbolTable::SYMBOL_NONE)
+  {
+    cout << "Error: interned symbols do not match the expected outcome" << endl;
+    return false;
+  }
+
+  for(uint c = 0; c < 200; ++c)
+    if(symbols[11 + c] != 3 + c || symbolTable.Find(input.c_str() + result.lexStream.data[11 + c].offset, (uint)result.lexStream.data[11 + c].length) != 3 + c)
+    {
+      cout << "Error: interned symbols do not match the expected outcome" << endl;
+      return false;
+    }
+  return true;
+}
+
+bool TestLexer9()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  lexer.CharToken("space", ' ');
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+  lexer.CharToken("dot", '.');
+  lexer.CharToken("minus", '-');
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+  // (Reals are split into several tokens since '.' and '-' are lex symbols)
+  const std::string input = "42 0x1F 3.25 1.5e-3 2e10 x.5 7. 12abc 18446744073709551616 0.1 123456789012345678901234 1 . 5";
+  ParseResult result;
+  result.inputStream.data = input.c_str();
+  result.inputStream.length = (ParseOffset)input.length();
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  result.decodeLiterals = true;
+  lexer.LexicalAnalysis(result);
+
+  struct ExpectedLiteral { NumericLiteral::LiteralType type; uint32 tokenCount; uint64 integer; double real; };
+  const ExpectedLiteral expected[] =
+  {
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 42, 0.0 },                        // 42
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 0x1F, 0.0 },                      // 0x1F
+    { NumericLiteral::LITERALTYPE_REAL, 3, 0, 3.25 },                           // 3 . 25
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_REAL, 5, 0, 1.5e-3 },                         // 1 . 5e - 3
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_REAL, 1, 0, 2e10 },                           // 2e10
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },                            // x
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },                            // .
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 5, 0.0 },                         // 5
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 7, 0.0 },                         // 7
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },                            // .
+    { NumericLiteral::LITERALTYPE_INVALID, 1, 0, 0.0 },                         // 12abc
+    { NumericLiteral::LITERALTYPE_INVALID, 1, 0, 0.0 },                         // (out of range)
+    { NumericLiteral::LITERALTYPE_REAL, 3, 0, 0.1 },                            // 0 . 1
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_INVALID, 1, 0, 0.0 },                         // (out of range)
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 1, 0.0 },                         // 1 (separated from the '.')
+    { NumericLiteral::LITERALTYPE_NONE, 0, 0, 0.0 },
+    { NumericLiteral::LITERALTYPE_INTEGER, 1, 5, 0.0 }
+  };
+  const uint nExpected = sizeof(expected) / sizeof(expected[0]);
+
+  if(result.literalStream.length != result.lexStream.length || result.lexStream.length != nExpected)
+  {
+    cout << "Error: the number of literals does not match the expected outcome" << endl;
+    return false;
+  }
+
+  for(uint c = 0; c < nExpected; ++c)
+  {
+    const NumericLiteral& literal = result.literalStream.data[c];
+    if(literal.type != expected[c].type || literal.tokenCount != expected[c].tokenCount
+      || (literal.type == NumericLiteral::LITERALTYPE_INTEGER && literal.integer != expected[c].integer)
+      || (literal.type == NumericLiteral::LITERALTYPE_REAL && literal.real != expected[c].real))
+    {
+      cout << "Error: decoded literal " << c << " does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+
+  // Real numbers that are not converted exactly by the fast path
+  const_cstring reals[] = { "123456789012345678901234.5", "1e300", "2.2250738585072014e-308", "0.30000000000000004", null };
+  for(uint c = 0; reals[c] != null; ++c)
+  {
+    NumericLiteral literal;
+    if(NumericLiteral::Decode(reals[c], reals[c] + strlen(reals[c]), literal) != reals[c] + strlen(reals[c])
+      || literal.type != NumericLiteral::LITERALTYPE_REAL || literal.real != strtod(reals[c], null))
+    {
+      cout << "Error: decoded real number does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestLexer10()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Index the lines of the input while lexing
+  const std::string input = "if a\n\n  b <= c\n\"x\" else";
+  LineIndex lineIndex;
+  ParseResult result;
+  result.inputStream.data = input.c_str();
+  result.inputStream.length = (ParseOffset)input.length();
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  result.lineIndex = &lineIndex;
+  lexer.LexicalAnalysis(result);
+
+  // (if a b < = c "x" else)
+  const uint expectedLines[] = { 1, 1, 3, 3, 3, 3, 4, 4, 4 };
+  const uint expectedColumns[] = { 1, 4, 3, 5, 6, 8, 1, 5, 9 };
+  if(lineIndex.GetLineCount() != 4 || lineIndex.GetLineStart(3) != 6 || result.lexStream.length != 8)
+  {
+    cout << "Error: line index does not match the expected outcome" << endl;
+    return false;
+  }
+  for(uint c = 0; c <= 8; ++c)
+  {
+    uint line, column;
+    lineIndex.GetTokenLocation(result, c, line, column);
+    if(line != expectedLines[c] || column != expectedColumns[c])
+    {
+      cout << "Error: location of lexical token " << c << " does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+
+  // Index the lines of an input large enough to be lexed on several threads
+  std::string largeInput;
+  while(largeInput.length() < 3 * 1024 * 1024)
+    largeInput += (largeInput.length() % 7 == 0)? "a <= b\n" : "if c\n\n";
+  MatchBuffer matches;
+  lexer.SetThreadCount(4);
+  lexer.LexicalAnalysis(largeInput.c_str(), (ParseOffset)largeInput.length(), 0, matches, &lineIndex);
+  lexer.SetThreadCount(1);
+
+  uint line = 1, column = 1;
+  for(uint c = 0; c < largeInput.length(); ++c)
+  {
+    if(c % 4093 == 0 || (largeInput[c] == '\n' && c % 97 == 0))
+    {
+      uint indexedLine, indexedColumn;
+      lineIndex.GetLocation(c, indexedLine, indexedColumn);
+      if(indexedLine != line || indexedColumn != column)
+      {
+        cout << "Error: location of input offset " << c << " does not match the expected outcome" << endl;
+        return false;
+      }
+    }
+    if(largeInput[c] == '\n') { ++line; column = 1; } else ++column;
+  }
+  if(lineIndex.GetLineCount() != line)
+  {
+    cout << "Error: number of indexed lines does not match the expected outcome" << endl;
+    return false;
+  }
+  return true;
+}
+
+bool TestLexer11()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Apply a sequence of edits to an input, lexing every edited input incrementally
+  // (The edits extend a word, join two words, open a string, close an unterminated comment and join two lines)
+  struct Edit { ParseOffset offset; ParseOffset removedLength; const_cstring insertedText; };
+  const Edit edits[] =
+  {
+    { 6, 0, "x" },
+    { 4, 1, "" },
+    { 20, 0, "\"" },
+    { 50, 0, "*/" },
+    { 13, 1, "" },
+    { 0, 0, "if /* " }
+  };
+  std::string input;
+  for(uint c = 0; c < 10; ++c)
+    input += "if a <= b\nelse c = \"d\" /* e\n";
+  input += "f ++ g // h";
+
+  MatchBuffer result;
+  lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), result);
+  for(uint c = 0; c < sizeof(edits) / sizeof(edits[0]); ++c)
+  {
+    input.replace(edits[c].offset, edits[c].removedLength, edits[c].insertedText);
+
+    MatchBuffer expected;
+    lexer.IncrementalAnalysis(input.c_str(), (ParseOffset)input.length(), 0, edits[c].offset, edits[c].removedLength, (ParseOffset)strlen(edits[c].insertedText), result);
+    lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), expected);
+
+    bool match = (result.GetLength() == expected.GetLength());
+    for(uint cMatch = 0; match && cMatch < result.GetLength(); ++cMatch)
+      match = result[cMatch].token == expected[cMatch].token && result[cMatch].offset == expected[cMatch].offset && result[cMatch].length == expected[cMatch].length;
+    if(!match)
+    {
+      cout << "Error: lexical tokens of edit " << c << " do not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestLexer12()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  const ParseToken tokenText = lexer.RegexToken("text", "\"([^\"\\\\\\n]|\\\\.)*\"");
+  lexer.Build(Lexer::TOKENTYPE_RAW);
+  lexer.RegexToken("blank", "[ \t\n]+");
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+  const ParseToken tokenHex = lexer.RegexToken("hex", "0[xX][0-9a-fA-F]+");
+  const ParseToken tokenReal = lexer.RegexToken("real", "\\d+\\.\\d+([eE][-+]?\\d+)?");
+  const ParseToken tokenInteger = lexer.RegexToken("integer", "\\d+");
+  const ParseToken tokenDot = lexer.CharToken(".", '.');
+  const ParseToken tokenMinus = lexer.CharToken("-", '-');
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+  // (Regular expressions match the longest input they can, even when it ends in a partial match: "7." is "7" ".")
+  const std::string input = "0x1F 3.25e-2\t42 \"a\\\"b\" 7. x-1.5e\n0x";
+  MatchBuffer matches;
+  lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), matches);
+
+  struct ExpectedMatch { ParseOffset offset; ParseLength length; ParseToken token; };
+  const ExpectedMatch expected[] =
+  {
+    { 0, 4, tokenHex },       // 0x1F
+    { 5, 7, tokenReal },      // 3.25e-2
+    { 13, 2, tokenInteger },  // 42
+    { 16, 6, tokenText },     // "a\"b"
+    { 23, 1, tokenInteger },  // 7
+    { 24, 1, tokenDot },      // .
+    { 26, 1, 0 },             // x
+    { 27, 1, tokenMinus },    // -
+    { 28, 3, tokenReal },     // 1.5
+    { 31, 1, 0 },             // e
+    { 33, 1, tokenInteger },  // 0
+    { 34, 1, 0 }              // x
+  };
+  const uint nExpected = sizeof(expected) / sizeof(expected[0]);
+  bool match = (matches.GetLength() == nExpected);
+  for(uint c = 0; match && c < nExpected; ++c)
+    match = matches[c].offset == expected[c].offset && matches[c].length == expected[c].length && (expected[c].token == 0 || matches[c].token == expected[c].token);
+  if(!match)
+  {
+    cout << "Error: lexical tokens matched by regular expressions do not match the expected outcome" << endl;
+    return false;
+  }
+
+  // Invalid patterns (and patterns that match the empty string) are rejected
+  const_cstring invalidPatterns[] = { "", "a|", "(a", "[a", "a{3,1}", "x*", "(a|b?)", "\\", null };
+  for(uint c = 0; invalidPatterns[c] != null; ++c)
+    if(Regex().Parse(invalidPatterns[c]))
+    {
+      cout << "Error: invalid regular expression \"" << invalidPatterns[c] << "\" was accepted" << endl;
+      return false;
+    }
+  return true;
+}
+
+bool TestLexer13()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  lexer.CharToken("space", ' ');
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+  const ParseToken tokenComma = lexer.CharToken(",", ',');
+  const ParseToken tokenSemicolon = lexer.CharToken(";", ';');
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+  const ParseToken tokenPass = lexer.StringToken("pass", "pass");
+  lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+
+  // Silence the separators and a keyword (only the ";" separator is used by the grammar)
+  GrammarLD grammar(parser.GetTokenRegistry());
+  grammar.BeginProduction("statement");
+    grammar.ProductionToken(TOKEN_TERMINAL_IDENTIFIER);
+    grammar.ProductionToken(tokenSemicolon);
+  grammar.EndProduction();
+  grammar.SilentTerminal(tokenComma);
+  grammar.SilentTerminal(tokenSemicolon);
+  grammar.SilentTerminal(tokenPass);
+
+  TerminalSet nilTerminals, maskedTerminals;
+  grammar.ClassifySilentTerminals(nilTerminals, maskedTerminals);
+  if(!nilTerminals.Contains(tokenComma) || nilTerminals.Contains(tokenSemicolon) || !maskedTerminals.Contains(tokenSemicolon) || maskedTerminals.Contains(tokenComma))
+  {
+    cout << "Error: silent terminals were not classified by their use in the grammar" << endl;
+    return false;
+  }
+  lexer.SetSilentTerminals(nilTerminals, maskedTerminals);
+
+  // The unused separator is discarded and the others are flagged
+  // (Silent lex words are always flagged rather than discarded)
+  const_cstring input = "a, b; pass,,c;";
+  ParseResult result;
+  result.inputStream.data = input;
+  result.inputStream.length = (ParseOffset)strlen(input);
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  lexer.LexicalAnalysis(result);
+
+  const ParseToken expectedTokens[] = { TOKEN_TERMINAL_IDENTIFIER, TOKEN_TERMINAL_IDENTIFIER, tokenSemicolon, tokenPass, TOKEN_TERMINAL_IDENTIFIER, tokenSemicolon };
+  const uint64 expectedMask = (1 << 2) | (1 << 3) | (1 << 5);
+  const uint nExpected = sizeof(expectedTokens) / sizeof(expectedTokens[0]);
+  bool match = (result.lexStream.length == nExpected && result.silentMask.length == 1 && result.silentMask.data[0] == expectedMask);
+  for(uint c = 0; match && c < nExpected; ++c)
+    match = (result.lexStream.data[c].token == expectedTokens[c]);
+  if(!match)
+  {
+    cout << "Error: silent tokens do not match the expected outcome" << endl;
+    PrintLexStream(result);
+    return false;
+  }
+  return true;
+}
+
+bool TestLexer14()
+{
+  typedef StaticLexer<StaticTestTokens> TestStaticLexer;
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  TestStaticLexer::DefineTokens(lexer);
+
+  if(TestStaticLexer::GetToken("<<") != parser.GetTokenRegistry().GetToken("<<") || TestStaticLexer::GetToken("else") != parser.GetTokenRegistry().GetToken("else"))
+  {
+    cout << "Error: static lexer token ids do not match the token registry" << endl;
+    return false;
+  }
+
+  // The static lexer produces the same lex stream as the runtime lexer
+  // (Including unterminated bounded tokens, a line comment at the end of the input and numeric words)
+  const_cstring inputs[] =
+  {
+    "if a <= b\nelse c = \"d\" /* e */ f << 2",
+    "x+++y==z<<=1 \"unterminated\nelse",
+    "/* open comment\n if",
+    "42abc<//< comment",
+    "",
+    null
+  };
+  for(uint c = 0; inputs[c] != null; ++c)
+  {
+    MatchBuffer expected, result;
+    lexer.LexicalAnalysis(inputs[c], (ParseOffset)strlen(inputs[c]), expected);
+    TestStaticLexer::LexicalAnalysis(inputs[c], (ParseOffset)strlen(inputs[c]), result);
+
+    bool match = (result.GetLength() == expected.GetLength());
+    for(uint cMatch = 0; match && cMatch < result.GetLength(); ++cMatch)
+      match = result[cMatch].token == expected[cMatch].token && result[cMatch].offset == expected[cMatch].offset && result[cMatch].length == expected[cMatch].length;
+    if(!match)
+    {
+      cout << "Error: static lexer tokens of input " << c << " do not match the expected outcome" << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TestLexer15()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  lexer.CharToken("space", ' ');
+  lexer.CharToken("newline", '\n');
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+  const ParseToken tokenNotEqual = lexer.StringToken("not equal", "\xe2\x89\xa0"); // (U+2260)
+  const ParseToken tokenAssign = lexer.CharToken("=", '=');
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+
+  // Multi-byte sequences are part of identifiers (and may also form lex symbols)
+  const_cstring input = "na\xc3\xafve\xe2\x89\xa0" "caf\xc3\xa9 = \xf0\x9f\x98\x80";
+  ParseResult result;
+  result.inputStream.data = input;
+  result.inputStream.length = (ParseOffset)strlen(input);
+  result.inputStream.elementSize = sizeof(char);
+  result.lexStream.elementSize = sizeof(ParseMatch);
+  result.validateUtf8 = true;
+  lexer.LexicalAnalysis(result);
+
+  struct ExpectedMatch { ParseOffset offset; ParseLength length; ParseToken token; };
+  const ExpectedMatch expected[] =
+  {
+    { 0, 6, TOKEN_TERMINAL_IDENTIFIER },  // naïve
+    { 6, 3, tokenNotEqual },              // ≠
+    { 9, 5, TOKEN_TERMINAL_IDENTIFIER },  // café
+    { 15, 1, tokenAssign },               // =
+    { 17, 4, TOKEN_TERMINAL_IDENTIFIER }  // (U+1F600)
+  };
+  const uint nExpected = sizeof(expected) / sizeof(expected[0]);
+  bool match = (result.lexStream.length == nExpected && result.invalidUtf8Offset == result.inputStream.length);
+  for(uint c = 0; match && c < nExpected; ++c)
+    match = result.lexStream.data[c].offset == expected[c].offset && result.lexStream.data[c].length == expected[c].length && result.lexStream.data[c].token == expected[c].token;
+  if(!match)
+  {
+    cout << "Error: lexical tokens of UTF-8 input do not match the expected outcome" << endl;
+    PrintLexStream(result);
+    return false;
+  }
+
+  // The first invalid sequence is located (an overlong encoding, a surrogate, a truncated sequence and a stray continuation byte)
+  // (The input is large enough to be validated in several blocks and lexed on several threads)
+  const_cstring invalidSequences[] = { "\xc0\xaf", "\xed\xa0\x80", "\xe2\x89", "\x80", null };
+  for(uint c = 0; invalidSequences[c] != null; ++c)
+  {
+    std::string invalidInput;
+    while(invalidInput.length() < 3 * 1024 * 1024)
+      invalidInput += "caf\xc3\xa9 \xe2\x89\xa0 na\xc3\xafve\n";
+    const ParseOffset invalidOffset = (ParseOffset)invalidInput.find('\n', invalidInput.length() * 2 / 3);
+    invalidInput.insert(invalidOffset, invalidSequences[c]);
+
+    for(uint nThreads = 1; nThreads <= 4; nThreads *= 4)
+    {
+      lexer.SetThreadCount(nThreads);
+      MatchBuffer matches;
+      ParseOffset invalidUtf8Offset = 0;
+      lexer.LexicalAnalysis(invalidInput.c_str(), (ParseOffset)invalidInput.length(), 0, matches, null, &invalidUtf8Offset);
+      if(invalidUtf8Offset != invalidOffset)
+      {
+        cout << "Error: invalid UTF-8 sequence " << c << " was not located (on " << nThreads << " threads)" << endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool TestLexer16()
+{
+  ParserLD parser;
+  Lexer lexer(parser.GetTokenRegistry());
+  BuildTestLexer1(lexer);
+
+  // Stream a long multi-line comment (only its opening boundary and the last character searched for "*/" are held back)
+  // (The comment is kept within the longest match length of narrow offsets)
+  const_cstring line = " a comment line with \"quotes\", // and * characters /\n";
+  std::string input = "x = a/*";
+  LexerStream stream(lexer);
+  LexerStream::Matches matches;
+  stream.Feed(input.c_str(), (ParseOffset)input.length(), matches);
+  for(uint c = 0; c < 1024; ++c)
+  {
+    stream.Feed(line, (ParseOffset)strlen(line), matches);
+    input += line;
+    if(stream.GetPendingLength() > 3)
+    {
+      cout << "Error: " << stream.GetPendingLength() << " characters of an open comment are held back by the lexer stream" << endl;
+      return false;
+    }
+  }
+
+  // The comment is matched in full once it is closed (and the matches that follow it are offset by the discarded characters)
+  const_cstring closing = "*/+ b";
+  stream.Feed(closing, (ParseOffset)strlen(closing), matches);
+  stream.Finish(matches);
+  input += closing;
+
+  MatchBuffer expected;
+  lexer.LexicalAnalysis(input.c_str(), (ParseOffset)input.length(), expected);
+  bool match = (matches.GetLength() == expected.GetLength());
+  for(uint c = 0; match && c < matches.GetLength(); ++c)
+    match = matches[c].token == expected[c].token && matches[c].offset == expected[c].offset && matches[c].length == expected[c].length;
+  if(!match)
+  {
+    cout << "Error: streamed lexical tokens of a long comment do not match the expected outcome" << endl;
+    return false;
+  }
+
+  // An unterminated comment is matched up to the end of the stream
+  stream.Reset();
+  matches.Clear();
+  stream.Feed(input.c_str(), (ParseOffset)input.length() - (ParseOffset)strlen(closing), matches);
+  stream.Finish(matches);
+  if(matches.GetLength() != 4 || matches[3].token != tokenComment || matches[3].offset != 5 || matches[3].length != (ParseLength)(input.length() - strlen(closing) - 5))
+  {
+    cout << "Error: an unterminated streamed comment does not match the expected outcome" << endl;
+    return false;
+  }
+  return true;
+}
+
+/*                                ENTRY POINT                               */
+int main()
+{
+  cout << "-----------------------------------" << endl
+       << "Testing Lexer: " << endl;
+  cout.flush();
+  if (TestLexer1() && TestLexer2() && TestLexer3() && TestLexer4() && TestLexer5() && TestLexer6() && TestLexer7() && TestLexer8() && TestLexer9() && TestLexer10() && TestLexer11() && TestLexer12() && TestLexer13() && TestLexer14() && TestLexer15() && TestLexer16())
+  {
+    cout << "SUCCESS" << endl;
+    cout.flush();
+    return 0;
+  }
+  else
+  {
+    return 1; // Test case failed
+  }
+}
@@ -113,7 +113,7 @@ ParseToken w = TOKEN_FLAG_SHIFT | 3;
 
 /*                                   TESTS                                  */
 // Build a left-recursive grammar with unbounded look-ahead (found at around page 23 of the draft)
-void BuildTestGrammar1(BuilderLD& builder)
+void BuildTestGrammar1(BuilderLD& builder, ParseToken x, ParseToken y, ParseToken z, ParseToken w)
 {
   ParseToken rule0 = 0; // 0.A -> x
   ParseToken rule1 = 1; // 1.B -> x
@@ -217,11 +217,25 @@ public:
   const ParseTokens& TEST_ConstructParser(BuilderLD& builder)
   {
     builder.ConstructParseTable(parseTable);
+    BuildTerminalSets();
     return parseTable;
   }
   
   // Test the recognition pass
   void TEST_RecognitionPass(ParseResult& parseResult, ParseTokens& rules) { RecognitionPass(parseResult, rules); }
+
+  // Test the recognition pass, lexing on demand
+  void TEST_RecognitionPass(ParseResult& parseResult, ParseTokens& rules, const Lexer& lexer)
+  {
+    delete[] parseResult.lexStream.data;
+    parseResult.lexStream.data = null;
+    parseResult.lexStream.length = 0;
+
+    MatchBuffer tokenMatches;
+    RecognitionPass(parseResult, rules, &lexer, tokenMatches);
+    parseResult.lexStream.length = tokenMatches.GetLength();
+    parseResult.lexStream.data = tokenMatches.Release();
+  }
 };
 
 bool TestGrammar1()
@@ -231,7 +245,7 @@ bool TestGrammar1()
   //// Build the parse table
   GrammarLD grammar(parser.GetTokenRegistry());
   BuilderLD builder;
-  BuildTestGrammar1(builder);
+  BuildTestGrammar1(builder, x, y, z, w);
   const ParseTokens& parseTable = parser.TEST_ConstructParser(builder);
 #ifdef TESTPARSERLD_DEBUG_INFO
   PrintParseTable(parseTable);
@@ -309,13 +323,85 @@ bool TestGrammar1()
   return true;
 }
 
+// Test the recognition pass with tokens lexed on demand (only the terminals accepted by the parse table are lexed)
+bool TestGrammar2()
+{
+  TestParserLD parser;
+
+  //// Build the lexer
+  // (The keyword "end" may be used as an identifier and "<<" may be lexed as "<" "<" where the grammar requires it)
+  Lexer lexer(parser.GetTokenRegistry());
+  lexer.CharToken("space", ' ');
+  lexer.Build(Lexer::TOKENTYPE_NIL);
+  const ParseToken less = lexer.CharToken("less", '<');
+  const ParseToken shiftLeft = lexer.StringToken("shift left", "<<");
+  lexer.Build(Lexer::TOKENTYPE_LEX_SYMBOL);
+  const ParseToken end = lexer.StringToken("end", "end");
+  lexer.Build(Lexer::TOKENTYPE_LEX_WORD);
+
+  //// Build the parse table
+  BuilderLD builder;
+  BuildTestGrammar1(builder, TOKEN_TERMINAL_IDENTIFIER, less, end, shiftLeft);
+  parser.TEST_ConstructParser(builder);
+
+  //// Construct some test inputs along with their expected results (rules and lexical tokens)
+  // Input 1: xyxyz (The first "end" is an identifier)
+  const_cstring input1 = "end < x<end";
+  ParseToken correctOutput1[] = { 0,2,3,0,2,4,7 };
+  ParseToken correctLexStream1[] = { TOKEN_TERMINAL_IDENTIFIER, less, TOKEN_TERMINAL_IDENTIFIER, less, end };
+
+  // Input 2: xyw (The "<<<" is split into "<" "<<")
+  const_cstring input2 = "a<<<";
+  ParseToken correctOutput2[] = { 1,2,5,8 };
+  ParseToken correctLexStream2[] = { TOKEN_TERMINAL_IDENTIFIER, less, shiftLeft };
+
+  //// Test the recognition pass
+  const_cstring inputs[] = { input1, input2 };
+  const ParseToken* correctOutputs[] = { correctOutput1, correctOutput2 };
+  const uint correctOutputLengths[] = { sizeof(correctOutput1)/sizeof(ParseToken), sizeof(correctOutput2)/sizeof(ParseToken) };
+  const ParseToken* correctLexStreams[] = { correctLexStream1, correctLexStream2 };
+  const uint correctLexStreamLengths[] = { sizeof(correctLexStream1)/sizeof(ParseToken), sizeof(correctLexStream2)/sizeof(ParseToken) };
+  for(uint cInput = 0; cInput < 2; ++cInput)
+  {
+    ParseResult parseResult;
+    parseResult.inputStream.data = inputs[cInput];
+    parseResult.inputStream.length = (ParseOffset)strlen(inputs[cInput]);
+    parseResult.inputStream.elementSize = sizeof(char);
+
+    ParseTokens rules;
+    parser.TEST_RecognitionPass(parseResult, rules, lexer);
+#ifdef TESTPARSERLD_DEBUG_INFO
+    PrintRules(rules);
+#endif
+    bool match = (rules.size() == correctOutputLengths[cInput]);
+    for(uint c = 0; match && c < rules.size(); ++c)
+      match = (rules[c] == correctOutputs[cInput][c]);
+    if(!match)
+    {
+      cout << "Error: rule does not match the expected outcome" << endl;
+      return false;
+    }
+
+    match = (parseResult.lexStream.length == correctLexStreamLengths[cInput]);
+    for(uint c = 0; match && c < parseResult.lexStream.length; ++c)
+      match = (parseResult.lexStream.data[c].token == correctLexStreams[cInput][c]);
+    if(!match)
+    {
+      cout << "Error: lexical token does not match the expected outcome" << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /*                                ENTRY POINT                               */
 int main()
 {
   cout << "-----------------------------------" << endl
        << "Testing ParserLD: " << endl;
   cout.flush();
-  if (TestGrammar1())  
+  if (TestGrammar1() && TestGrammar2())  
   {
     cout << "SUCCESS" << endl;
     cout.flush();